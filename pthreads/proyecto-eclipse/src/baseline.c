@@ -0,0 +1,87 @@
+#include "baseline.h"
+
+void baseline_key_init(baseline_key_t *key, int m, int k, int n, int quant_bits) {
+	cpu_model_read(key->cpu_model, sizeof(key->cpu_model));
+	
+	key->m          = m;
+	key->k          = k;
+	key->n          = n;
+	key->quant_bits = quant_bits;
+}
+
+/*
+ * Cada línea: modelo, tipo, m, k, n, bits y
+ * nanosegundos, separados por tabuladores. Retorna
+ * true si la línea es de la clave y deja su tiempo
+ * en "nanos".
+ */
+static bool match_line(const char *linea, const baseline_key_t *key, long long *nanos) {
+	char modelo[128], tipo[16];
+	int m, k, n, bits;
+	long long valor;
+	
+	if (sscanf(linea, "%127[^\t]\t%15[^\t]\t%d\t%d\t%d\t%d\t%lld", modelo, tipo,
+			&m, &k, &n, &bits, &valor) != 7)
+		return false;
+	
+	if (strcmp(modelo, key->cpu_model) != 0 || 
+			strcmp(tipo, MATRIX_ELEM_T_NAME) != 0 ||
+			m != key->m || k != key->k || n != key->n || 
+			bits != key->quant_bits)
+		return false;
+	
+	*nanos = valor;
+	return true;
+}
+
+bool baseline_load(const baseline_key_t *key, long long *nanos) {
+	FILE *archivo = NULL;
+	char linea[512];
+	bool encontrado = false;
+	
+	if ((archivo = fopen(BASELINE_FILE, "r")) == NULL)
+		return false;
+	
+	while (!encontrado && fgets(linea, sizeof(linea), archivo) != NULL)
+		encontrado = match_line(linea, key, nanos);
+	
+	fclose(archivo);
+	return encontrado;
+}
+
+void baseline_store(const baseline_key_t *key, long long nanos) {
+	FILE *archivo = NULL, *temporal = NULL;
+	char linea[512];
+	long long valor;
+	bool ok;
+	
+	if ((temporal = fopen(BASELINE_FILE ".tmp", "w")) == NULL) {
+		LOG(WARN, "Error al abrir archivo de referencia \"%s\". %s", 
+				BASELINE_FILE ".tmp", "El tiempo secuencial no se guardará.");
+		return;
+	}
+	
+	/*
+	 * Se copian las líneas de las demás claves y la
+	 * de esta clave se reemplaza (al final), de modo
+	 * que el archivo tiene una sola línea por clave.
+	 */
+	if ((archivo = fopen(BASELINE_FILE, "r")) != NULL) {
+		while (fgets(linea, sizeof(linea), archivo) != NULL)
+			if (!match_line(linea, key, &valor))
+				fputs(linea, temporal);
+		fclose(archivo);
+	}
+	
+	fprintf(temporal, "%s\t%s\t%d\t%d\t%d\t%d\t%lld\n", key->cpu_model, 
+			MATRIX_ELEM_T_NAME, key->m, key->k, key->n, key->quant_bits, nanos);
+	
+	ok = !ferror(temporal);
+	ok = (fclose(temporal) == 0) && ok;
+	
+	if (!ok || rename(BASELINE_FILE ".tmp", BASELINE_FILE) != 0) {
+		LOG(WARN, "Error al escribir archivo de referencia \"%s\". %s", 
+				BASELINE_FILE, "El tiempo secuencial no se guardará.");
+		remove(BASELINE_FILE ".tmp");
+	}
+}
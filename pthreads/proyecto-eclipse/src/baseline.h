@@ -0,0 +1,51 @@
+#ifndef BASELINE_H_
+#define BASELINE_H_
+
+#include "matrix.h"
+
+/*
+ * Nombre del archivo en el que se guardan los
+ * tiempos de la multiplicación secuencial de
+ * referencia, para no medirlos en cada ejecución.
+ */
+#define BASELINE_FILE "matrix-mult_base.csv"
+
+/*
+ * Clave de un tiempo de referencia: modelo de
+ * procesador, tipo de elemento, dimensiones
+ * (C = A x B, con A de m x k y B de k x n) y
+ * bits de cuantización.
+ */
+typedef struct {
+	char cpu_model[128];
+	int m, k, n;
+	int quant_bits;
+} baseline_key_t;
+
+/*
+ * Inicializa la clave con el modelo del
+ * procesador actual.
+ */
+void baseline_key_init(baseline_key_t *key, int m, int k, int n, int quant_bits);
+
+/*
+ * Busca en BASELINE_FILE el tiempo secuencial (en
+ * nanosegundos) de la clave. Retorna false si no
+ * se encontró.
+ */
+bool baseline_load(const baseline_key_t *key, long long *nanos);
+
+/*
+ * Guarda en BASELINE_FILE el tiempo secuencial
+ * (en nanosegundos) de la clave, reemplazando el
+ * anterior si lo había.
+ */
+void baseline_store(const baseline_key_t *key, long long nanos);
+
+/*
+ * Cantidad de operaciones (multiplicaciones y
+ * sumas) de C = A x B: 2 * m * n * k.
+ */
+#define MATRIX_MULT_OPS(m, k, n) (2.0 * (double) (m) * (double) (n) * (double) (k))
+
+#endif /*BASELINE_H_*/
@@ -1,23 +1,85 @@
 #include "config.h"
 
+#include <fcntl.h>
+
 void como_usar(void) {
 	printf("Modo de uso:\n");
-	printf("    matrix-mult [-a fil col -b fil col [-h hilos [-t part]] [-ni]]\n");
+	printf("    matrix-mult [-a fil col | -A arch] [-b fil col | -B arch] [-C arch] [-h hilos [-t part] [-af]] [-tb l1 l2 l3] [-q bits] [-sw corte] [-l disp] [-ni] [--stream] [--ooc mem] [--hugepages] [--counters]\n");
+	printf("    matrix-mult --sweep -s tams [-h hilos] [-t parts] [-w calent] [-r reps] [-tb l1 l2 l3] [--hugepages] [--counters]\n");
 	printf("\n");
 	printf("Opciones:\n");
 	printf("    (sin opciones se imprime una multiplicación de ejemplo)\n");
 	printf("\n");
 	printf("    a fil col : cantidad de filas y columnas de la matriz A\n");
 	printf("    b fil col : cantidad de filas y columnas de la matriz B\n");
+	printf("    A arch    : leer la matriz A del archivo \"arch\", binario\n");
+	printf("                (proyectado en memoria, sin copiarlo) o de\n");
+	printf("                texto (con el formato de las matrices impresas)\n");
+	printf("    B arch    : leer la matriz B del archivo \"arch\"\n");
+	printf("    C arch    : guardar la matriz C en el archivo binario \"arch\"\n");
 	printf("    h hilos   : cantidad de hilos (0 por defecto)\n");
-	printf("    t part    : tipo de particionamiento (1 por defecto)\n");
+	printf("    t part    : tipo de particionamiento (1 por defecto), o auto\n");
+	printf("                para elegir particionamiento, grilla y cantidad\n");
+	printf("                de hilos (hasta \"hilos\") con un modelo de\n");
+	printf("                cómputo y tráfico de memoria\n");
+	printf("    af        : fijar cada hilo a un procesador, repartiendo\n");
+	printf("                los hilos entre los nodos NUMA, e inicializar\n");
+	printf("                cada partición desde el hilo que la procesa\n");
+	printf("    tb l1 l2 l3 : tamaños de bloque para las cachés L1 (kc),\n");
+	printf("                  L2 (mc) y L3 (nc) (por defecto se calculan\n");
+	printf("                  a partir de las cachés leídas de sysfs)\n");
+	printf("    q bits    : almacenar A y B cuantizadas con enteros de\n");
+	printf("                8 o 16 bits, acumulando C en 32 bits\n");
+	printf("    sw corte  : multiplicar con Strassen-Winograd, recursando\n");
+	printf("                mientras las dimensiones superen el corte\n");
+	printf("                (no aplica con -q)\n");
+	printf("    l disp    : disposición de las matrices para multiplicar:\n");
+	printf("                filas (por defecto) o morton (bloques en orden\n");
+	printf("                Z, con multiplicación recursiva; no aplica con\n");
+	printf("                -q ni -sw)\n");
 	printf("    ni        : no imprimir las matrices\n");
+	printf("    stream    : imprimir las matrices mientras se multiplica,\n");
+	printf("                escribiendo cada franja de filas de C apenas\n");
+	printf("                queda completa (con -h; no aplica con -sw,\n");
+	printf("                -l morton ni particionamiento 3d)\n");
+	printf("    ooc mem   : multiplicar fuera de memoria, leyendo A y B\n");
+	printf("                por franjas de los archivos binarios de -A y\n");
+	printf("                -B y guardando C por bloques en el de -C, con\n");
+	printf("                a lo sumo \"mem\" MiB de buffers\n");
+	printf("    hugepages : almacenar A, B y C en páginas grandes (de\n");
+	printf("                hugetlbfs o transparentes), cargadas en\n");
+	printf("                paralelo por los hilos antes de multiplicar\n");
+	printf("    counters  : medir en cada hilo los contadores de hardware\n");
+	printf("                (ciclos, instrucciones, fallos de L1D, LLC,\n");
+	printf("                DTLB y de predicción de saltos)\n");
+	printf("\n");
+	printf("Modo barrido (--sweep):\n");
+	printf("    s tams    : lista de tamaños de matrices cuadradas (400,800,...)\n");
+	printf("    h hilos   : lista de cantidades de hilos, 0 es secuencial (0)\n");
+	printf("    t parts   : lista de tipos de particionamiento (1)\n");
+	printf("    w calent  : ejecuciones descartadas por configuración (1)\n");
+	printf("    r reps    : ejecuciones medidas por configuración (5)\n");
+	printf("    hugepages : almacenar las matrices en páginas grandes\n");
+	printf("    counters  : promedio por ejecución de los contadores de hardware\n");
+	printf("    Se imprimen mediana, mínimo y desvío de cada configuración\n");
+	printf("    en %s y %s\n", SWEEP_CSV_FILE, SWEEP_JSON_FILE);
 	printf("\n");
 	printf("Argumentos:\n");
 	printf("    fil   : entero positivo\n");
 	printf("    col   : entero positivo\n");
-	printf("    hilos : entero positivo (cuadrado perfecto si part es 2)\n");
-	printf("    part  : 1 ó 2\n");
+	printf("    arch  : archivo binario con cabecera (dimensiones, tipo y\n");
+	printf("            dimensión principal) y elementos %s por filas,\n", MATRIX_ELEM_T_NAME);
+	printf("            o de texto con una fila por línea y cada elemento\n");
+	printf("            seguido de un tabulador\n");
+	printf("    hilos : entero positivo\n");
+	printf("    part  : 1 (filas), 2 (filas y columnas), 3 (bloques\n");
+	printf("            dinámicos con robo de trabajo) ó 4 (filas,\n");
+	printf("            columnas y dimensión común, con reducción\n");
+	printf("            de las C parciales)\n");
+	printf("    l1, l2, l3 : entero positivo (elementos)\n");
+	printf("    bits  : 8 ó 16\n");
+	printf("    disp  : filas ó morton\n");
+	printf("    corte : entero positivo (al menos %d)\n", STRASSEN_MIN_CUTOFF);
 	
 	exit(0);
 }
@@ -90,6 +152,44 @@ void set_params(param_t *params, int argc, char **argv, bool *thread_count_read,
 					i += 2;
 				}
 			}
+			else if (strcmp(argv[i], "-A") == 0 || strcmp(argv[i], "-B") == 0) {
+				/*
+				 * Verificar que haya al menos un
+				 * argumento más y que sea un archivo
+				 * de matrices válido, del que se toman
+				 * las dimensiones.
+				 */
+				condicion = i + 1 < argc;
+				
+				if (condicion && strcmp(argv[i], "-A") == 0) {
+					condicion = matrix_file_info(argv[i + 1], &params->matrix_a_fil, 
+							&params->matrix_a_col);
+					params->file_a      = argv[i + 1];
+					matrix_a_sizes_read = condicion;
+				}
+				else if (condicion) {
+					condicion = matrix_file_info(argv[i + 1], &params->matrix_b_fil, 
+							&params->matrix_b_col);
+					params->file_b      = argv[i + 1];
+					matrix_b_sizes_read = condicion;
+				}
+				
+				// Avanzamos el indice
+				i += 1;
+			}
+			else if (strcmp(argv[i], "-C") == 0) {
+				/*
+				 * Verificar que haya al menos
+				 * un argumento más.
+				 */
+				condicion = i + 1 < argc;
+				
+				if (condicion)
+					params->file_c = argv[i + 1];
+				
+				// Avanzamos el indice
+				i += 1;
+			}
 			else if (strcmp(argv[i], "-h") == 0) {
 				/*
 				 * Verificar que haya al menos
@@ -131,29 +231,158 @@ void set_params(param_t *params, int argc, char **argv, bool *thread_count_read,
 				 * que haber leído.
 				 */
 				condicion = (i + 1 < argc) &&
-							is_number(argv[i + 1]) &&
+							(is_number(argv[i + 1]) || strcmp(argv[i + 1], "auto") == 0) &&
 							(*thread_count_read);
 
-				if (condicion) {
+				if (condicion && strcmp(argv[i + 1], "auto") == 0) {
+					/*
+					 * El particionamiento se elige luego,
+					 * con las dimensiones y los techos del
+					 * equipo. Hasta entonces, 2d.
+					 */
+					params->distrib_type = 2;
+					params->distrib_auto = true;
+					distrib_type_read = true;
+					
+					// Avanzamos el indice
+					i += 1;
+				}
+				else if (condicion) {
 					params->distrib_type = atoi(argv[i + 1]);
+					params->distrib_auto = false;
 					distrib_type_read = true;
 					
 					// Avanzamos el indice
 					i += 1;
 					
-					// Tipo de distribución debe ser 1d o 2d
-					if (params->distrib_type != 1 && params->distrib_type != 2)
+					// Tipo de distribución debe ser 1d, 2d o dinámica
+					if (params->distrib_type < 1 || params->distrib_type > 4)
 						condicion = false;
+				}
+			}
+			else if (strcmp(argv[i], "-af") == 0) {
+				/*
+				 * La cantidad de hilos ya se tuvo
+				 * que haber leído.
+				 */
+				condicion = (*thread_count_read);
+				
+				if (condicion)
+					params->affinity = true;
+			}
+			else if (strcmp(argv[i], "-tb") == 0) {
+				/*
+				 * Verificar que hayan al menos tres
+				 * argumentos más y que estos sean
+				 * números enteros positivos.
+				 */
+				condicion = i + 3 < argc &&
+							is_number(argv[i + 1]) &&
+							is_number(argv[i + 2]) &&
+							is_number(argv[i + 3]);
+				
+				if (condicion) {
+					params->tile_kc = atoi(argv[i + 1]);
+					params->tile_mc = atoi(argv[i + 2]);
+					params->tile_nc = atoi(argv[i + 3]);
 					
-					/*
-					 * Si tipo de distribución es 2d, la cantidad de
-					 * hilos debe ser un cuadrado perfecto.
-					 */
-					if (params->distrib_type == 2 && 
-							!es_cuadrado_perfecto(params->thread_count))
+					if (params->tile_kc == 0 || params->tile_mc == 0 || 
+							params->tile_nc == 0)
 						condicion = false;
+					
+					// Avanzamos el indice
+					i += 3;
+				}
+			}
+			else if (strcmp(argv[i], "-q") == 0) {
+				/*
+				 * Verificar que haya al menos un
+				 * argumento más y que sea 8 o 16.
+				 */
+				condicion = (i + 1 < argc) && is_number(argv[i + 1]);
+				
+				if (condicion) {
+					params->quant_bits = atoi(argv[i + 1]);
+					
+					if (params->quant_bits != 8 && params->quant_bits != 16)
+						condicion = false;
+					
+					// Avanzamos el indice
+					i += 1;
+				}
+			}
+			else if (strcmp(argv[i], "-sw") == 0) {
+				/*
+				 * Verificar que haya al menos un
+				 * argumento más y que sea un número
+				 * entero no menor al corte mínimo.
+				 */
+				condicion = (i + 1 < argc) && is_number(argv[i + 1]);
+				
+				if (condicion) {
+					params->strassen_cutoff = atoi(argv[i + 1]);
+					
+					if (params->strassen_cutoff < STRASSEN_MIN_CUTOFF)
+						condicion = false;
+					
+					// Avanzamos el indice
+					i += 1;
+				}
+			}
+			else if (strcmp(argv[i], "-l") == 0) {
+				/*
+				 * Verificar que haya al menos un
+				 * argumento más y que sea una
+				 * disposición conocida.
+				 */
+				condicion = (i + 1 < argc) && (strcmp(argv[i + 1], "filas") == 0 || 
+							strcmp(argv[i + 1], "morton") == 0);
+				
+				if (condicion) {
+					params->layout = strcmp(argv[i + 1], "morton") == 0 ? 
+							LAYOUT_MORTON : LAYOUT_ROWS;
+					
+					// Avanzamos el indice
+					i += 1;
+				}
+			}
+			else if (strcmp(argv[i], "--hugepages") == 0) {
+				/*
+				 * Almacenaremos las matrices en
+				 * páginas grandes.
+				 */
+				params->hugepages = true;
+			}
+			else if (strcmp(argv[i], "--counters") == 0) {
+				/*
+				 * Mediremos los contadores de hardware
+				 * de cada hilo.
+				 */
+				params->counters = true;
+			}
+			else if (strcmp(argv[i], "--ooc") == 0) {
+				/*
+				 * Verificar que haya al menos un
+				 * argumento más y que sea un número
+				 * entero positivo (MiB).
+				 */
+				condicion = (i + 1 < argc) && is_number(argv[i + 1]) && 
+							atol(argv[i + 1]) > 0;
+				
+				if (condicion) {
+					params->ooc_budget = (size_t) atol(argv[i + 1]) << 20;
+					
+					// Avanzamos el indice
+					i += 1;
 				}
 			}
+			else if (strcmp(argv[i], "--stream") == 0) {
+				/*
+				 * Imprimiremos las matrices mientras
+				 * se multiplica.
+				 */
+				params->stream = true;
+			}
 			else if (strcmp(argv[i], "-ni") == 0) {
 				/*
 				 * No imprimiremos las matrices como
@@ -165,6 +394,14 @@ void set_params(param_t *params, int argc, char **argv, bool *thread_count_read,
 			if (!condicion)
 				break;
 		}
+		
+		// Las dimensiones de A y B son obligatorias
+		condicion = condicion && matrix_a_sizes_read && matrix_b_sizes_read;
+		
+		// Fuera de memoria, las tres matrices están en archivos
+		if (params->ooc_budget > 0)
+			condicion = condicion && params->file_a != NULL && params->file_b != NULL &&
+						params->file_c != NULL;
 	}
 	
 	/*
@@ -192,9 +429,9 @@ void adjust_thread_count(param_t *params) {
 	 */
 	bool condicion1 = (params->matrix_a_fil) < (params->thread_count);
 	
-	int thread_count_sqrt = (int) sqrt(params->thread_count);
-	bool condicion2 = (params->matrix_a_fil) < (thread_count_sqrt) ||
-					  (params->matrix_b_col) < (thread_count_sqrt);
+	int grid_rows, grid_cols;
+	bool condicion2 = !grid_2d_shape(params->matrix_a_fil, params->matrix_b_col,
+									 params->thread_count, &grid_rows, &grid_cols);
 	
 	
 	if (params->distrib_type == 1 && condicion1) {
@@ -212,34 +449,184 @@ void adjust_thread_count(param_t *params) {
 	else if (params->distrib_type == 2 && condicion2) {
 		/* 
 		 * Análogamente, cuando el particionamiento es 2d 
-		 * (dos dimensiones), la raíz cuadrada de la cantidad 
-		 * de hilos no puede ser menor a la cantidad de filas
-		 * o a la cantidad de columnas de la matriz (de
-		 * salida) C.
-		 * Asignamos una cantidad "uniforme" igual al cuadrado
-		 * del máximo entre la raíz cuadrada de la cantidad de
-		 * filas y la raíz cuadrada de la cantidad de columnas
-		 * de la matriz (de salida) C. 
+		 * (dos dimensiones), la cantidad de hilos debe poder
+		 * factorizarse en una grilla de p x q con p no mayor
+		 * a la cantidad de filas y q no mayor a la cantidad
+		 * de columnas de la matriz (de salida) C.
+		 * Reducimos la cantidad de hilos hasta la mayor que
+		 * admite tal grilla.
 		 */
-		int matrix_a_fil_sqrt = (int) sqrt(params->matrix_a_fil);
-		int matrix_b_col_sqrt = (int) sqrt(params->matrix_b_col);
-		
-		params->thread_count = matrix_a_fil_sqrt > matrix_b_col_sqrt ?
-							   matrix_a_fil_sqrt :
-							   matrix_b_col_sqrt;
+		while (!grid_2d_shape(params->matrix_a_fil, params->matrix_b_col,
+							  params->thread_count, &grid_rows, &grid_cols))
+			params->thread_count--;
 		
-		params->thread_count *= params->thread_count;
 		LOG(INFO, "Cantidad de hilos ajustada a %d", params->thread_count);
 	}
+	else if (params->distrib_type == 4) {
+		/*
+		 * En 3d la grilla tampoco puede superar ninguna
+		 * de las tres dimensiones del producto.
+		 */
+		int grid_depth;
+		
+		if (!grid_3d_shape(params->matrix_a_fil, params->matrix_b_col, params->matrix_a_col,
+						   params->thread_count, &grid_rows, &grid_cols, &grid_depth)) {
+			while (!grid_3d_shape(params->matrix_a_fil, params->matrix_b_col, 
+								  params->matrix_a_col, params->thread_count, 
+								  &grid_rows, &grid_cols, &grid_depth))
+				params->thread_count--;
+			
+			LOG(INFO, "Cantidad de hilos ajustada a %d", params->thread_count);
+		}
+	}
+}
+
+/*
+ * Multiplica un bloque de C con las matrices
+ * (posiblemente cuantizadas) de los argumentos.
+ */
+static void mult_rows(matrix_mult_args *aux, int row_begin, int row_count,
+		int col_begin, int col_count) {
+	
+	if (aux->qmatrix_a != NULL && aux->qmatrix_b != NULL)
+		qmatrix_mult(aux->qmatrix_a, aux->qmatrix_b, aux->matrix_c, 
+				row_begin, row_count, col_begin, col_count);
+	else
+		matrix_mult(aux->matrix_a, aux->matrix_b, aux->matrix_c, 
+				row_begin, row_count, col_begin, col_count);
+}
+
+/*
+ * Multiplica un bloque de C. Con escritura en flujo,
+ * el bloque se recorre en franjas de filas que se
+ * informan a medida que terminan, para que el
+ * escritor no espere al bloque completo.
+ */
+static void mult_block(matrix_mult_args *aux, int row_begin, int row_count,
+		int col_begin, int col_count) {
+	
+	int franjas, i, inicio, fin;
+	
+	if (aux->stream == NULL) {
+		mult_rows(aux, row_begin, row_count, col_begin, col_count);
+		return;
+	}
+	if (col_count <= 0)
+		return;
+	
+	franjas = MAX(1, MIN(STREAM_BANDS_PER_BLOCK, row_count / STREAM_MIN_BAND_ROWS));
+	for (i=0; i < franjas; i++) {
+		inicio = row_begin + (int) ((long) row_count * i / franjas);
+		fin    = row_begin + (int) ((long) row_count * (i + 1) / franjas);
+		
+		mult_rows(aux, inicio, fin - inicio, col_begin, col_count);
+		stream_rows_done(aux->stream, inicio, fin - inicio);
+	}
 }
 
-void *matrix_mult_thread(void *args) {
+/*
+ * Multiplica un bloque entregado por el planificador.
+ */
+static void mult_tile(void *args, const sched_tile_t *tile) {
+	mult_block((matrix_mult_args *) args, tile->row_begin, tile->row_count,
+			tile->col_begin, tile->col_count);
+}
+
+void matrix_mult_thread(void *args) {
 	matrix_mult_args *aux = (matrix_mult_args *) args;
+	counter_set_t contadores;
+	long long cpu_begin;
+	
+	if (aux->counters_enabled)
+		counters_start(&contadores);
 	
-	matrix_mult(aux->matrix_a, aux->matrix_b, aux->matrix_c, 
-				aux->row_begin, aux->row_count, aux->col_begin, aux->col_count);
+	cpu_begin = get_thread_cpu_nanos();
+	TIME_BEGIN(aux->times);
 	
-	pthread_exit((void *) 0);
+	// La C parcial se reutiliza entre ejecuciones
+	if (aux->k_group > 0)
+		matrix_clear(aux->matrix_c, aux->row_begin, aux->row_count,
+				aux->col_begin, aux->col_count);
+	
+	if (aux->sched != NULL)
+		sched_run(aux->sched, aux->thread_id, mult_tile, aux);
+	else
+		mult_block(aux, aux->row_begin, aux->row_count, 
+				aux->col_begin, aux->col_count);
+	
+	TIME_END(aux->times);
+	aux->times.cpu = get_thread_cpu_nanos() - cpu_begin;
+	
+	if (aux->counters_enabled)
+		counters_stop(&contadores, &aux->counters);
+}
+
+void matrix_mult_sequential(matrix_t *mat_a, matrix_t *mat_b, qmatrix_t *qmat_a,
+		qmatrix_t *qmat_b, matrix_t *mat_c) {
+	
+	if (qmat_a != NULL && qmat_b != NULL)
+		qmatrix_mult(qmat_a, qmat_b, mat_c, 
+					 0, matrix_rows(mat_c), 
+					 0, matrix_cols(mat_c));
+	else
+		matrix_mult(mat_a, mat_b, mat_c, 
+					0, matrix_rows(mat_c), 
+					0, matrix_cols(mat_c));
+}
+
+void matrix_init_thread(void *args) {
+	matrix_init_args *aux = (matrix_init_args *) args;
+	matrix_mult_args *part = aux->partition;
+	sched_tile_t *tile;
+	int j;
+	
+	// Franja de filas de B que carga este hilo
+	int b_rows  = aux->matrix_b != NULL ? matrix_rows(aux->matrix_b) : 0;
+	int b_begin = (int) ((long long) part->thread_id * b_rows / aux->thread_count);
+	int b_end   = (int) ((long long) (part->thread_id + 1) * b_rows / aux->thread_count);
+	
+	if (part->sched != NULL) {
+		/*
+		 * Distribución dinámica: el hilo inicializa los
+		 * bloques con los que comienza su cola.
+		 */
+		sched_deque_t *deque = &part->sched->deques[part->thread_id];
+		
+		for (j=deque->top; j < deque->bottom; j++) {
+			tile = &part->sched->tiles[j];
+			
+			matrix_clear(part->matrix_c, tile->row_begin, tile->row_count,
+					tile->col_begin, tile->col_count);
+			if (tile->col_begin == 0 && aux->matrix_a != NULL)
+				matrix_fill_rows(aux->matrix_a, tile->row_begin, tile->row_count,
+						aux->seed_a);
+		}
+	}
+	else {
+		matrix_clear(part->matrix_c, part->row_begin, part->row_count,
+				part->col_begin, part->col_count);
+		
+		/*
+		 * Las filas de A las carga el hilo de la primera
+		 * columna (y, en 3d, del primer grupo).
+		 */
+		if (part->col_begin == 0 && part->k_group == 0 && aux->matrix_a != NULL)
+			matrix_fill_rows(aux->matrix_a, part->row_begin, part->row_count,
+					aux->seed_a);
+	}
+	
+	if (aux->matrix_b != NULL)
+		matrix_fill_rows(aux->matrix_b, b_begin, b_end - b_begin, aux->seed_b);
+}
+
+const char *distrib_name(int distrib_type) {
+	switch (distrib_type) {
+		case 1:  return "1d";
+		case 2:  return "2d";
+		case 3:  return "dinámico";
+		case 4:  return "3d";
+		default: return "desconocido";
+	}
 }
 
 void distrib_1d(matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c, 
@@ -275,95 +662,497 @@ void distrib_1d(matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c,
 		arguments[thread_count - 1].row_count += remainder_rows;
 }
 
+bool grid_2d_shape(int rows, int cols, int thread_count, int *grid_rows, 
+		int *grid_cols) {
+	
+	double costo, mejor_costo = 0.0;
+	bool encontrada = false;
+	int p, q;
+	
+	for (p=1; p <= thread_count; p++) {
+		if (thread_count % p != 0)
+			continue;
+		
+		q = thread_count / p;
+		if (p > rows || q > cols)
+			continue;
+		
+		/*
+		 * Cada hilo lee rows/p filas de A y cols/q
+		 * columnas de B; elegimos la grilla que
+		 * minimiza ese volumen, es decir, la de
+		 * bloques más cercanos a un cuadrado.
+		 */
+		costo = DOUBLE(rows) / p + DOUBLE(cols) / q;
+		if (!encontrada || costo < mejor_costo) {
+			mejor_costo = costo;
+			*grid_rows  = p;
+			*grid_cols  = q;
+			encontrada  = true;
+		}
+	}
+	
+	return encontrada;
+}
+
 void distrib_2d(matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c, 
 		int thread_count, matrix_mult_args *arguments) {
 	
 	int i, j, k;
-	int thread_count_sqrt = (int) sqrt(thread_count);
+	int grid_rows, grid_cols;
+	
+	if (!grid_2d_shape(matrix_rows(mat_c), matrix_cols(mat_c), thread_count,
+					   &grid_rows, &grid_cols))
+		LOG(FATAL, "No existe una grilla 2d para %d hilos.", thread_count);
 	
 	// Realizamos la división del trabajo
-	int rows_count     = matrix_rows(mat_c) / thread_count_sqrt;
-	int cols_count     = matrix_cols(mat_c) / thread_count_sqrt;
-	int remainder_rows = matrix_rows(mat_c) % thread_count_sqrt;
-	int remainder_cols = matrix_cols(mat_c) % thread_count_sqrt;
+	int rows_count     = matrix_rows(mat_c) / grid_rows;
+	int cols_count     = matrix_cols(mat_c) / grid_cols;
+	int remainder_rows = matrix_rows(mat_c) % grid_rows;
+	int remainder_cols = matrix_cols(mat_c) % grid_cols;
 
-	// Distribuimos el trabajo
+	/*
+	 * Distribuimos el trabajo. Las filas y columnas
+	 * sobrantes se reparten de a una entre las primeras
+	 * filas y columnas de la grilla, de modo que ningún
+	 * hilo recibe más de una fila o columna extra.
+	 */
 	k=0;
-	for (i=0; i < thread_count_sqrt; i++) {
-		for (j=0; j < thread_count_sqrt; j++) {
+	for (i=0; i < grid_rows; i++) {
+		for (j=0; j < grid_cols; j++) {
 			// A cada uno se les asigna las matrices
 			arguments[k].matrix_a  = mat_a;
 			arguments[k].matrix_b  = mat_b;
 			arguments[k].matrix_c  = mat_c;
 			
-			// A cada uno se asigna rows_count filas
-			arguments[k].row_begin = i * rows_count;
-			arguments[k].row_count = rows_count;
+			// A cada uno se asigna rows_count filas (más una sobrante)
+			arguments[k].row_begin = i * rows_count + MIN(i, remainder_rows);
+			arguments[k].row_count = rows_count + (i < remainder_rows ? 1 : 0);
 			
-			// A cada uno se asignan todas las columnas
-			arguments[k].col_begin = j * cols_count;
-			arguments[k].col_count = cols_count;
+			// A cada uno se asigna cols_count columnas (más una sobrante)
+			arguments[k].col_begin = j * cols_count + MIN(j, remainder_cols);
+			arguments[k].col_count = cols_count + (j < remainder_cols ? 1 : 0);
 			
 			++k;
 		}
+	}
+}
+
+bool grid_3d_shape(int rows, int cols, int depth, int thread_count, int *grid_rows,
+		int *grid_cols, int *grid_depth) {
+	
+	double costo, mejor_costo = 0.0;
+	bool encontrada = false;
+	int p, q, r;
+	
+	for (p=1; p <= thread_count; p++) {
+		if (thread_count % p != 0 || p > rows)
+			continue;
 		
-		/*
-		 * Si sobraron columnas sin asignar, éstas
-		 * son asignadas al hilo en cuestión.
-		 */
-		if (remainder_cols > 0)
-			arguments[k].col_count += remainder_cols;
+		for (q=1; q <= thread_count / p; q++) {
+			if ((thread_count / p) % q != 0 || q > cols)
+				continue;
+			
+			r = thread_count / (p * q);
+			if (r > depth)
+				continue;
+			
+			/*
+			 * Cada hilo lee un bloque de A de rows/p x depth/r,
+			 * uno de B de depth/r x cols/q, y escribe uno de C
+			 * de rows/p x cols/q. Con r > 1, la reducción lee
+			 * dos y escribe una de r - 1 matrices de rows x
+			 * cols, repartidas entre todos los hilos.
+			 */
+			costo = DOUBLE(rows) / p * depth / r + DOUBLE(depth) / r * cols / q +
+					DOUBLE(rows) / p * cols / q + 
+					3.0 * (r - 1) * rows * cols / thread_count;
+			
+			if (!encontrada || costo < mejor_costo) {
+				mejor_costo = costo;
+				*grid_rows  = p;
+				*grid_cols  = q;
+				*grid_depth = r;
+				encontrada  = true;
+			}
+		}
 	}
 	
+	return encontrada;
+}
+
+void distrib_3d(matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c, 
+		int thread_count, matrix_mult_args *arguments) {
+	
+	int grid_rows, grid_cols, grid_depth;
+	int i, j, g, k, row_end, col_end, k_end;
+	matrix_t **partials;
+	
+	if (!grid_3d_shape(matrix_rows(mat_c), matrix_cols(mat_c), matrix_cols(mat_a),
+					   thread_count, &grid_rows, &grid_cols, &grid_depth))
+		LOG(FATAL, "No existe una grilla 3d para %d hilos.", thread_count);
+	
 	/*
-	 * Si sobraron filas sin asignar, éstas
-	 * son asignadas a los hilos que recibieron
-	 * las últimas filas.
+	 * C parciales: la del primer grupo es la propia C.
+	 * Cada hilo pone a cero (y así toca por primera
+	 * vez) su bloque de la parcial de su grupo.
 	 */
-	if (remainder_rows > 0) {
-		k = thread_count - thread_count_sqrt;
-		while (k < thread_count) {
-			arguments[k].row_count += remainder_rows;
-			++k;
+	partials    = GET_MEM(matrix_t *, grid_depth);
+	partials[0] = mat_c;
+	for (g=1; g < grid_depth; g++)
+		matrix_alloc(&partials[g], matrix_rows(mat_c), matrix_cols(mat_c));
+	
+	k=0;
+	for (g=0; g < grid_depth; g++) {
+		for (i=0; i < grid_rows; i++) {
+			for (j=0; j < grid_cols; j++) {
+				// Rango de la dimensión común del grupo
+				arguments[k].k_begin = (int) ((long) matrix_cols(mat_a) * g / grid_depth);
+				k_end                = (int) ((long) matrix_cols(mat_a) * (g + 1) / grid_depth);
+				arguments[k].k_count = k_end - arguments[k].k_begin;
+				
+				matrix_block(&arguments[k].slice_a, mat_a, 0, arguments[k].k_begin,
+						matrix_rows(mat_a), arguments[k].k_count);
+				matrix_block(&arguments[k].slice_b, mat_b, arguments[k].k_begin, 0,
+						arguments[k].k_count, matrix_cols(mat_b));
+				
+				// A cada uno se les asigna las porciones de A y B y su C parcial
+				arguments[k].matrix_a      = &arguments[k].slice_a;
+				arguments[k].matrix_b      = &arguments[k].slice_b;
+				arguments[k].matrix_c      = partials[g];
+				arguments[k].k_group       = g;
+				arguments[k].partials      = partials;
+				arguments[k].partial_count = grid_depth;
+				
+				// Bloque de filas y columnas de C
+				arguments[k].row_begin = (int) ((long) matrix_rows(mat_c) * i / grid_rows);
+				row_end                = (int) ((long) matrix_rows(mat_c) * (i + 1) / grid_rows);
+				arguments[k].row_count = row_end - arguments[k].row_begin;
+				arguments[k].col_begin = (int) ((long) matrix_cols(mat_c) * j / grid_cols);
+				col_end                = (int) ((long) matrix_cols(mat_c) * (j + 1) / grid_cols);
+				arguments[k].col_count = col_end - arguments[k].col_begin;
+				
+				++k;
+			}
 		}
 	}
 }
 
-void print_matrices(matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c) {
-	FILE *archivo = NULL;
+/*
+ * Suma de una franja de filas de una C parcial
+ * sobre otra.
+ */
+typedef struct {
+	matrix_t *dst;
+	matrix_t *src;
+	int row_begin;
+	int row_count;
+} reduce_args;
+
+static void reduce_thread(void *args) {
+	reduce_args *aux = (reduce_args *) args;
+	matrix_elem_t *fila_dst, *fila_src;
+	int i, j;
+	
+	for (i=aux->row_begin; i < aux->row_begin + aux->row_count; i++) {
+		fila_dst = matrix_row(aux->dst, i);
+		fila_src = matrix_row(aux->src, i);
+		
+		for (j=0; j < matrix_cols(aux->dst); j++)
+			fila_dst[j] += fila_src[j];
+	}
+}
+
+void reduce_partials(pool_t *pool, matrix_mult_args *arguments, int thread_count) {
+	matrix_t **partials;
+	reduce_args *trabajos;
+	int count, rows, paso, pares, franjas, g, f, n;
+	
+	if (thread_count <= 0 || arguments[0].partials == NULL || 
+			arguments[0].partial_count <= 1)
+		return;
+	
+	partials = arguments[0].partials;
+	count    = arguments[0].partial_count;
+	rows     = matrix_rows(partials[0]);
+	n        = thread_count + count;
+	trabajos = GET_MEM(reduce_args, n);
+	
+	/*
+	 * En cada nivel del árbol, la parcial g recibe la
+	 * g + paso (g múltiplo de 2·paso). Cada par se
+	 * divide en franjas de filas para ocupar a todos
+	 * los hilos.
+	 */
+	for (paso=1; paso < count; paso *= 2) {
+		pares   = (count - paso + 2 * paso - 1) / (2 * paso);
+		franjas = MAX(1, MIN(rows, thread_count / pares));
+		n       = 0;
+		
+		for (g=0; g + paso < count; g += 2 * paso)
+		for (f=0; f < franjas; f++) {
+			trabajos[n].dst       = partials[g];
+			trabajos[n].src       = partials[g + paso];
+			trabajos[n].row_begin = (int) ((long) rows * f / franjas);
+			trabajos[n].row_count = (int) ((long) rows * (f + 1) / franjas) - 
+					trabajos[n].row_begin;
+			
+			pool_submit(pool, reduce_thread, &trabajos[n]);
+			n++;
+		}
+		pool_wait(pool);
+	}
+	
+	free(trabajos);
+}
+
+void distrib_release(matrix_mult_args *arguments, int thread_count) {
+	int g;
+	
+	if (thread_count <= 0)
+		return;
 	
-	if ((archivo = fopen(OUTPUT_FILE, "w")) == NULL) {
+	if (arguments[0].sched != NULL)
+		sched_destroy(arguments[0].sched);
+	
+	if (arguments[0].partials != NULL) {
+		for (g=1; g < arguments[0].partial_count; g++)
+			matrix_destroy(arguments[0].partials[g]);
+		free(arguments[0].partials);
+	}
+}
+
+void distrib_tiles(matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c, 
+		int thread_count, matrix_mult_args *arguments) {
+	
+	sched_t *sched;
+	int i;
+	
+	sched_create(&sched, matrix_rows(mat_c), matrix_cols(mat_c), thread_count);
+	
+	for (i=0; i < thread_count; i++) {
+		// A cada uno se les asigna las matrices
+		arguments[i].matrix_a  = mat_a;
+		arguments[i].matrix_b  = mat_b;
+		arguments[i].matrix_c  = mat_c;
+		
+		// Los bloques se toman del planificador
+		arguments[i].sched     = sched;
+		arguments[i].thread_id = i;
+		
+		// Rango inicial: toda la matriz C
+		arguments[i].row_begin = 0;
+		arguments[i].row_count = matrix_rows(mat_c);
+		arguments[i].col_begin = 0;
+		arguments[i].col_count = matrix_cols(mat_c);
+	}
+}
+
+void distribute(int distrib_type, matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c, 
+		int thread_count, matrix_mult_args *arguments) {
+	
+	int i;
+	
+	if (distrib_type == 1)
+		distrib_1d(mat_a, mat_b, mat_c, thread_count, arguments);
+	else if (distrib_type == 2)
+		distrib_2d(mat_a, mat_b, mat_c, thread_count, arguments);
+	else if (distrib_type == 3)
+		distrib_tiles(mat_a, mat_b, mat_c, thread_count, arguments);
+	else if (distrib_type == 4)
+		distrib_3d(mat_a, mat_b, mat_c, thread_count, arguments);
+	else
+		LOG(FATAL, "Particionamiento distinto a 1d, 2d, dinámico y 3d");
+	
+	for (i=0; i < thread_count; i++)
+		arguments[i].thread_id = i;
+}
+
+void print_matrices(matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c, pool_t *pool,
+		int thread_count) {
+	
+	const char *titulos[] = {"Matriz A\n", "Matriz B\n", "Matriz C\n"};
+	matrix_t *matrices[] = {mat_a, mat_b, mat_c};
+	off_t posicion = 0;
+	int fd, i;
+	
+	if ((fd = open(OUTPUT_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
 		LOG(WARN, "Error al abrir archivo de matrices \"%s\". %s", 
 				OUTPUT_FILE, "Las matrices no se imprimirán.");
 		return;
 	}
 	
-	fprintf(archivo, "Matriz A\n");
-	matrix_print(mat_a, archivo);
-	fprintf(archivo, "\n");
-	fflush(archivo);
+	/*
+	 * Cada matriz se convierte en paralelo y sus
+	 * franjas se escriben en su posición; los títulos
+	 * y las líneas en blanco, entre una y otra.
+	 */
+	for (i=0; i < 3; i++) {
+		if (!matrix_file_pwrite(fd, titulos[i], strlen(titulos[i]), posicion))
+			break;
+		posicion += strlen(titulos[i]);
+		
+		posicion = matrix_file_print(matrices[i], fd, posicion, pool, thread_count);
+		
+		if (!matrix_file_pwrite(fd, "\n", 1, posicion))
+			break;
+		posicion += 1;
+	}
+	
+	if (i < 3)
+		LOG(WARN, "Error al escribir el archivo de matrices \"%s\".", OUTPUT_FILE);
+	
+	close(fd);
+}
 
-	fprintf(archivo, "Matriz B\n");
-	matrix_print(mat_b, archivo);
-	fprintf(archivo, "\n");
-	fflush(archivo);
+/*
+ * Suma los contadores de hardware de todos los hilos.
+ */
+static counters_t counters_total(matrix_mult_args *arguments, int thread_count) {
+	counters_t total;
+	int i;
+	
+	memset(&total, 0, sizeof(counters_t));
+	for (i=0; i < thread_count; i++)
+		counters_add(&total, &arguments[i].counters);
+	
+	return total;
+}
 
-	fprintf(archivo, "Matriz C\n");
-	matrix_print(mat_c, archivo);
+/*
+ * Imprime los totales de los contadores de hardware
+ * y las relaciones derivadas: instrucciones por ciclo
+ * y fallos por cada mil instrucciones.
+ */
+static void print_counters_summary(matrix_mult_args *arguments, int thread_count) {
+	counters_t total = counters_total(arguments, thread_count);
+	long long instrucciones = total.values[COUNTER_INSTRUCTIONS];
+	int i;
+	
+	fprintf(stdout, "\nContadores de hardware (total de los hilos)\n");
+	for (i=0; i < COUNTER_COUNT; i++) {
+		if (total.values[i] < 0)
+			fprintf(stdout, "    %-14s no disponible\n", counter_name(i));
+		else if (i == COUNTER_INSTRUCTIONS || i == COUNTER_CYCLES || instrucciones <= 0)
+			fprintf(stdout, "    %-14s %lld\n", counter_name(i), total.values[i]);
+		else
+			fprintf(stdout, "    %-14s %lld (%.3f por mil instrucciones)\n", counter_name(i), 
+					total.values[i], 1000.0 * total.values[i] / instrucciones);
+	}
+	
+	if (instrucciones > 0 && total.values[COUNTER_CYCLES] > 0)
+		fprintf(stdout, "    %-14s %f\n", "IPC", 
+				DOUBLE(instrucciones) / total.values[COUNTER_CYCLES]);
+}
+
+/*
+ * Escribe en el archivo de tiempos un registro por
+ * hilo con su partición y sus contadores, y uno con
+ * los totales. Los contadores no disponibles se
+ * escriben como -1.
+ */
+static void print_counters_records(FILE *archivo, matrix_mult_args *arguments, 
+		int thread_count) {
+	counters_t total = counters_total(arguments, thread_count);
+	int i, j;
+	
+	fprintf(archivo, "CNOM\tFilaIni\tFilaCant\tColumIni\tColumCant");
+	for (j=0; j < COUNTER_COUNT; j++)
+		fprintf(archivo, "\t%s", counter_name(j));
 	fprintf(archivo, "\n");
-	fflush(archivo);
 	
-	fclose(archivo);
+	for (i=0; i < thread_count; i++) {
+		fprintf(archivo, "C%03d\t%d\t%d\t%d\t%d", i, arguments[i].row_begin, 
+				arguments[i].row_count, arguments[i].col_begin, arguments[i].col_count);
+		for (j=0; j < COUNTER_COUNT; j++)
+			fprintf(archivo, "\t%lld", arguments[i].counters.values[j]);
+		fprintf(archivo, "\n");
+	}
+	
+	fprintf(archivo, "CTOT\t0\t%d\t0\t%d", matrix_rows(arguments[0].matrix_c),
+			matrix_cols(arguments[0].matrix_c));
+	for (j=0; j < COUNTER_COUNT; j++)
+		fprintf(archivo, "\t%lld", total.values[j]);
+	fprintf(archivo, "\n");
 }
 
 void print_times(time_rec_t tiempo_total_multip, time_rec_t tiempo_total_partit,
-			time_rec_t tiempo_total_thr_creat, time_rec_t tiempo_total_thr_exec,
-			int thread_count, matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c) {
+			pool_stats_t despacho_pool, time_rec_t tiempo_total_thr_exec,
+			long long tiempo_base, const roofline_t *roof, 
+			matrix_mult_args *arguments, int thread_count, 
+			matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c) {
 	
 	FILE *archivo = NULL;
+	roofline_point_t punto = {0};
+	double rendimiento = 0.0, aceleracion = 0.0, eficiencia = 0.0;
+	long long ejecucion, ejecucion_min = 0, ejecucion_max = 0;
+	double ejecucion_prom = 0.0, cpu_prom = 0.0, desbalance = 0.0;
+	int i;
+	
+	/*
+	 * Tiempo total de despacho: desde que se encoló el
+	 * primer trabajo hasta que comenzó el último. Tiempo
+	 * promedio: espera media de cada trabajo en la cola.
+	 */
+	long long despacho_total = despacho_pool.jobs > 0 ?
+			despacho_pool.last_start - despacho_pool.first_submit : 0;
+	double despacho_prom = despacho_pool.jobs > 0 ?
+			despacho_pool.latency_sum / DOUBLE(despacho_pool.jobs) : 0.0;
+	
+	/*
+	 * Tiempos de ejecución de cada hilo: mínimo, máximo
+	 * y promedio. El desbalance es la relación entre el
+	 * hilo más lento y el promedio (1 si están parejos).
+	 */
+	if (arguments != NULL && thread_count > 0) {
+		for (i=0; i < thread_count; i++) {
+			ejecucion = TIME_DIFF(arguments[i].times);
+			
+			if (i == 0 || ejecucion < ejecucion_min)
+				ejecucion_min = ejecucion;
+			if (i == 0 || ejecucion > ejecucion_max)
+				ejecucion_max = ejecucion;
+			
+			ejecucion_prom += ejecucion;
+			cpu_prom       += arguments[i].times.cpu;
+		}
+		
+		ejecucion_prom /= thread_count;
+		cpu_prom       /= thread_count;
+		desbalance      = ejecucion_prom > 0.0 ? ejecucion_max / ejecucion_prom : 0.0;
+	}
+	
+	/*
+	 * Operaciones por segundo (2·M·N·K operaciones,
+	 * en miles de millones: operaciones / ns). La
+	 * aceleración se calcula contra el tiempo secuencial
+	 * de referencia, y la eficiencia es la aceleración
+	 * por hilo.
+	 */
+	if (TIME_DIFF(tiempo_total_multip) > 0) {
+		rendimiento = MATRIX_MULT_OPS(matrix_rows(mat_a), matrix_cols(mat_a), 
+				matrix_cols(mat_b)) / TIME_DIFF(tiempo_total_multip);
+		
+		if (tiempo_base > 0) {
+			aceleracion = tiempo_base / DOUBLE(TIME_DIFF(tiempo_total_multip));
+			eficiencia  = aceleracion / MAX(thread_count, 1);
+		}
+	}
 	
 	/*
-	 * Impresión en la salida estándar
+	 * Ubicación en el modelo "roofline": intensidad
+	 * aritmética, techo alcanzable y si el techo es el
+	 * ancho de banda de memoria o el pico de cómputo.
+	 */
+	if (roof != NULL)
+		roofline_place(roof, MATRIX_MULT_OPS(matrix_rows(mat_a), matrix_cols(mat_a), 
+				matrix_cols(mat_b)), roofline_traffic(matrix_rows(mat_a), 
+				matrix_cols(mat_a), matrix_cols(mat_b)), TIME_DIFF(tiempo_total_multip),
+				thread_count, &punto);
+	
+	/*
+	 * Impresión en la salida estándar (tiempos
+	 * en milisegundos).
 	 */
 	fprintf(stdout, "Matriz A (MatA)...%dx%d\n", matrix_rows(mat_a), 
 			matrix_cols(mat_a));
@@ -373,20 +1162,70 @@ void print_times(time_rec_t tiempo_total_multip, time_rec_t tiempo_total_partit,
 			matrix_cols(mat_c));
 	
 	fprintf(stdout, "Cantidad de Hilos (CH)...................%d\n", thread_count);
+	fprintf(stdout, "Micro-núcleo (MN)........................%s\n", 
+			quant_bits() > 0 ? quant_kernel_get()->name : gemm_kernel_get()->name);
+	if (quant_bits() > 0)
+		fprintf(stdout, "Bits Cuantización (BQ)...................%d\n", quant_bits());
 	
-	fprintf(stdout, "Tiempo Total Multiplicación (TTM)........%lld\n", 
-			TIME_DIFF(tiempo_total_multip));
-	fprintf(stdout, "Tiempo Total Particionamiento (TTP)......%lld\n", 
-			TIME_DIFF(tiempo_total_partit));
-	fprintf(stdout, "Tiempo Total Creación Hilos (TTCH).......%lld\n", 
-			TIME_DIFF(tiempo_total_thr_creat));
-	fprintf(stdout, "Tiempo Total Ejecución Hilos (TTEH)......%lld\n", 
-			TIME_DIFF(tiempo_total_thr_exec));
-
-	fprintf(stdout, "Tiempo Promedio Creación Hilos (TPCH)....%f\n",
-			TIME_DIFF(tiempo_total_thr_creat) / DOUBLE(thread_count));
+	fprintf(stdout, "Tiempo Total Multiplicación (TTM)........%f\n", 
+			NANOS_TO_MILLIS(TIME_DIFF(tiempo_total_multip)));
+	fprintf(stdout, "Tiempo Total Particionamiento (TTP)......%f\n", 
+			NANOS_TO_MILLIS(TIME_DIFF(tiempo_total_partit)));
+	fprintf(stdout, "Tiempo Total Despacho Pool (TTDP)........%f\n", 
+			NANOS_TO_MILLIS(despacho_total));
+	fprintf(stdout, "Tiempo Total Ejecución Hilos (TTEH)......%f\n", 
+			NANOS_TO_MILLIS(TIME_DIFF(tiempo_total_thr_exec)));
+
+	fprintf(stdout, "Tiempo Promedio Despacho Pool (TPDP).....%f\n",
+			NANOS_TO_MILLIS(despacho_prom));
 	fprintf(stdout, "Tiempo Promedio Ejecución Hilos (TPEH)...%f\n",
-			TIME_DIFF(tiempo_total_thr_exec) / DOUBLE(thread_count));
+			NANOS_TO_MILLIS(ejecucion_prom));
+	fprintf(stdout, "Tiempo Mínimo Ejecución Hilos (TNEH).....%f\n",
+			NANOS_TO_MILLIS(ejecucion_min));
+	fprintf(stdout, "Tiempo Máximo Ejecución Hilos (TXEH).....%f\n",
+			NANOS_TO_MILLIS(ejecucion_max));
+	fprintf(stdout, "Tiempo Promedio CPU Hilos (TPCH).........%f\n",
+			NANOS_TO_MILLIS(cpu_prom));
+	fprintf(stdout, "Desbalance Hilos (DH, máximo/promedio)...%f\n",
+			desbalance);
+	fprintf(stdout, "%s%f\n", quant_bits() == 0 && strcmp(MATRIX_OPS_UNIT, "GFLOPS") == 0 ?
+			"Operaciones por Segundo (GFLOPS)........." :
+			"Operaciones por Segundo (GIOPS)..........", rendimiento);
+	if (tiempo_base > 0) {
+		fprintf(stdout, "Tiempo Base Secuencial (TBS).............%f\n",
+				NANOS_TO_MILLIS(tiempo_base));
+		fprintf(stdout, "Aceleración (AC).........................%f\n", aceleracion);
+		fprintf(stdout, "Eficiencia (EF)..........................%f\n", eficiencia);
+	}
+	if (roof != NULL) {
+		fprintf(stdout, "Ancho de Banda Memoria (BW, GB/s)........%f\n", roof->bandwidth);
+		fprintf(stdout, "Pico de Cómputo (PC, por hilos usados)...%f\n", punto.peak);
+		fprintf(stdout, "Intensidad Aritmética (IA, ops/byte).....%f\n", punto.intensity);
+		fprintf(stdout, "Techo Alcanzable (TA)....................%f\n", punto.attainable);
+		fprintf(stdout, "Fracción del Pico (FP)...................%f\n", 
+				punto.peak > 0.0 ? punto.achieved / punto.peak : 0.0);
+		fprintf(stdout, "Fracción del Techo (FT)..................%f\n", 
+				punto.attainable > 0.0 ? punto.achieved / punto.attainable : 0.0);
+		fprintf(stdout, "Límite (LIM).............................%s\n", 
+				punto.memory_bound ? "memoria" : "cómputo");
+	}
+	
+	/*
+	 * Detalle por hilo. La espera es el tiempo que
+	 * el hilo quedó ocioso desde que terminó hasta
+	 * que terminaron todos (fin de TTEH).
+	 */
+	if (arguments != NULL && thread_count > 0) {
+		fprintf(stdout, "\nHilo  Ejecución     CPU           Espera\n");
+		for (i=0; i < thread_count; i++)
+			fprintf(stdout, "%-5d %-13f %-13f %f\n", i, 
+					NANOS_TO_MILLIS(TIME_DIFF(arguments[i].times)),
+					NANOS_TO_MILLIS(arguments[i].times.cpu),
+					NANOS_TO_MILLIS(tiempo_total_thr_exec.end - arguments[i].times.end));
+		
+		if (arguments[0].counters_enabled)
+			print_counters_summary(arguments, thread_count);
+	}
 
 	/*
 	 * Apertura de archivo
@@ -398,16 +1237,50 @@ void print_times(time_rec_t tiempo_total_multip, time_rec_t tiempo_total_partit,
 	}
 	
 	/*
-	 * Escritura en archivo.
+	 * Escritura en archivo (tiempos en nanosegundos).
 	 */
 	fprintf(archivo, "MatA\t%dx%d\n", matrix_rows(mat_a), matrix_cols(mat_a));
 	fprintf(archivo, "MatB\t%dx%d\n", matrix_rows(mat_b), matrix_cols(mat_b));
 	fprintf(archivo, "MatC\t%dx%d\n", matrix_rows(mat_c), matrix_cols(mat_c));
 	fprintf(archivo, "CH  \t%d\n", thread_count);
+	fprintf(archivo, "MN  \t%s\n", 
+			quant_bits() > 0 ? quant_kernel_get()->name : gemm_kernel_get()->name);
+	fprintf(archivo, "BQ  \t%d\n", quant_bits());
 	fprintf(archivo, "TTM \t%lld\n", TIME_DIFF(tiempo_total_multip));
 	fprintf(archivo, "TTP \t%lld\n", TIME_DIFF(tiempo_total_partit));
-	fprintf(archivo, "TTCH\t%lld\n", TIME_DIFF(tiempo_total_thr_creat));
+	fprintf(archivo, "TTDP\t%lld\n", despacho_total);
 	fprintf(archivo, "TTEH\t%lld\n", TIME_DIFF(tiempo_total_thr_exec));
+	fprintf(archivo, "TPEH\t%.0f\n", ejecucion_prom);
+	fprintf(archivo, "TNEH\t%lld\n", ejecucion_min);
+	fprintf(archivo, "TXEH\t%lld\n", ejecucion_max);
+	fprintf(archivo, "TPCH\t%.0f\n", cpu_prom);
+	fprintf(archivo, "DH  \t%f\n", desbalance);
+	fprintf(archivo, "GOPS\t%f\n", rendimiento);
+	fprintf(archivo, "TBS \t%lld\n", tiempo_base);
+	fprintf(archivo, "AC  \t%f\n", aceleracion);
+	fprintf(archivo, "EF  \t%f\n", eficiencia);
+	if (roof != NULL) {
+		fprintf(archivo, "BW  \t%f\n", roof->bandwidth);
+		fprintf(archivo, "PC  \t%f\n", punto.peak);
+		fprintf(archivo, "IA  \t%f\n", punto.intensity);
+		fprintf(archivo, "TA  \t%f\n", punto.attainable);
+		fprintf(archivo, "FP  \t%f\n", punto.peak > 0.0 ? punto.achieved / punto.peak : 0.0);
+		fprintf(archivo, "FT  \t%f\n", 
+				punto.attainable > 0.0 ? punto.achieved / punto.attainable : 0.0);
+		fprintf(archivo, "LIM \t%s\n", punto.memory_bound ? "memoria" : "computo");
+	}
+	
+	// Un registro por hilo: ejecución, CPU y espera
+	if (arguments != NULL) {
+		for (i=0; i < thread_count; i++)
+			fprintf(archivo, "H%03d\t%lld\t%lld\t%lld\n", i, 
+					TIME_DIFF(arguments[i].times), arguments[i].times.cpu,
+					tiempo_total_thr_exec.end - arguments[i].times.end);
+		
+		// Contadores de hardware junto a la partición de cada hilo
+		if (thread_count > 0 && arguments[0].counters_enabled)
+			print_counters_records(archivo, arguments, thread_count);
+	}
 	
 	fclose(archivo);
 }
@@ -425,10 +1298,64 @@ void print_partitions(matrix_mult_args *arguments, int thread_count) {
 		return;
 	}
 	
-	fprintf(archivo, "Hilo,FilaIni,FilaCant,ColumIni,ColumCant\n");
+	if (thread_count > 0 && arguments[0].sched != NULL) {
+		/*
+		 * Distribución dinámica: un registro por cada
+		 * bloque ejecutado, indicando si fue robado.
+		 */
+		sched_t *sched = arguments[0].sched;
+		int j;
+		
+		fprintf(archivo, "Hilo,FilaIni,FilaCant,ColumIni,ColumCant,Robado\n");
+		for (i=0; i < thread_count; i++)
+		for (j=0; j < sched->tile_count; j++) {
+			if (sched->executed_by[j] != i)
+				continue;
+			
+			fprintf(archivo, "%d,%d,%d,%d,%d,%d\n", i, sched->tiles[j].row_begin,
+				sched->tiles[j].row_count, sched->tiles[j].col_begin, 
+				sched->tiles[j].col_count, sched->stolen[j] ? 1 : 0);
+		}
+	}
+	else if (thread_count > 0 && arguments[0].partials != NULL) {
+		/*
+		 * Distribución 3d: se agrega el rango de la
+		 * dimensión común de cada hilo.
+		 */
+		fprintf(archivo, "Hilo,FilaIni,FilaCant,ColumIni,ColumCant,KIni,KCant\n");
+		for (i=0; i < thread_count; i++) {
+			fprintf(archivo, "%d,%d,%d,%d,%d,%d,%d\n", i, arguments[i].row_begin,
+				arguments[i].row_count, arguments[i].col_begin, arguments[i].col_count,
+				arguments[i].k_begin, arguments[i].k_count);
+		}
+	}
+	else {
+		fprintf(archivo, "Hilo,FilaIni,FilaCant,ColumIni,ColumCant\n");
+		for (i=0; i < thread_count; i++) {
+			fprintf(archivo, "%d,%d,%d,%d,%d\n", i, arguments[i].row_begin,
+				arguments[i].row_count, arguments[i].col_begin, arguments[i].col_count);
+		}
+	}
+	
+	fclose(archivo);
+}
+
+void print_placement(const cpu_topology_t *topo, const int *place, int thread_count) {
+	FILE *archivo = NULL;
+	const cpu_info_t *cpu;
+	int i;
+	
+	if ((archivo = fopen(PLACE_FILE, "w")) == NULL) {
+		LOG(WARN, "Error al abrir archivo de ubicación \"%s\". %s", 
+				PLACE_FILE, "La ubicación no se imprimirá.");
+		return;
+	}
+	
+	fprintf(archivo, "Hilo,CPU,Nucleo,Socket,Nodo\n");
 	for (i=0; i < thread_count; i++) {
-		fprintf(archivo, "%d,%d,%d,%d,%d\n", i, arguments[i].row_begin,
-			arguments[i].row_count, arguments[i].col_begin, arguments[i].col_count);
+		cpu = &topo->cpus[place[i]];
+		fprintf(archivo, "%d,%d,%d,%d,%d\n", i, cpu->cpu, cpu->core, 
+				cpu->package, cpu->node);
 	}
 	
 	fclose(archivo);
@@ -1,10 +1,24 @@
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
 #include "matrix.h"
+#include "matrix_file.h"
+#include "gemm.h"
+#include "quant.h"
+#include "pool.h"
+#include "sched.h"
+#include "stream.h"
+#include "ooc.h"
+#include "strassen.h"
+#include "morton.h"
+#include "baseline.h"
+#include "roofline.h"
 
 /*
  * Rango de cantidad de argumentos.
  */
-#define MIN_ARGS_COUNT 6
-#define MAX_ARGS_COUNT 11
+#define MIN_ARGS_COUNT 4
+#define MAX_ARGS_COUNT 32
 
 /*
  * Máxima cantidad de hilos.
@@ -35,6 +49,30 @@
  */
 #define PARTIT_FILE "matrix-mult_particiones.csv"
 
+/*
+ * Nombre del archivo de salida, en
+ * el que se imprimirá la ubicación
+ * (procesador y nodo) de cada hilo.
+ */
+#define PLACE_FILE "matrix-mult_ubicacion.csv"
+
+/*
+ * Nombres de los archivos de salida del
+ * modo barrido (--sweep), en los que se
+ * imprimen las estadísticas de cada
+ * configuración.
+ */
+#define SWEEP_CSV_FILE  "matrix-mult_barrido.csv"
+#define SWEEP_JSON_FILE "matrix-mult_barrido.json"
+
+/*
+ * Disposición de las matrices en memoria para
+ * la multiplicación: por filas, o por bloques
+ * en orden Morton (ver morton.h).
+ */
+#define LAYOUT_ROWS   0
+#define LAYOUT_MORTON 1
+
 /*
  * Tipo de datos que agrupa
  * los parametros del programa.
@@ -43,8 +81,40 @@ typedef struct {
 	int matrix_a_fil, matrix_a_col;
 	int matrix_b_fil, matrix_b_col;
 	int thread_count, distrib_type;
+	int tile_kc, tile_mc, tile_nc;
+	int quant_bits;
+	int strassen_cutoff;	// 0: multiplicación clásica
+	int layout;
+	bool distrib_auto;		// -t auto: lo elige el modelo (ver model.h)
+	bool affinity;
+	bool hugepages;
+	bool counters;
+	bool stream;			// --stream: escribir C mientras se multiplica
+	size_t ooc_budget;		// --ooc: memoria (en bytes) de la multiplicación
+							// fuera de memoria (ver ooc.h), 0 si no se usa
+	const char *file_a;		// -A, -B y -C: archivos binarios
+	const char *file_b;		// de las matrices (ver matrix_file.h)
+	const char *file_c;
 } param_t;
 
+/*
+ * Argumentos de la inicialización de las matrices
+ * por parte de un hilo (primer acceso): pone a cero
+ * su partición de C, carga las filas de A que le
+ * corresponden y una franja de filas de B (sobre
+ * las matrices completas matrix_a y matrix_b). Si
+ * matrix_a o matrix_b es nula (leída de un archivo),
+ * no se carga.
+ */
+typedef struct {
+	matrix_mult_args *partition;
+	matrix_t *matrix_a;
+	matrix_t *matrix_b;
+	int thread_count;
+	unsigned int seed_a;
+	unsigned int seed_b;
+} matrix_init_args;
+
 /*
  * Imprime una ayuda de cómo se debe
  * utilizar el programa y termina.
@@ -68,9 +138,31 @@ void set_params(param_t *params, int argc, char **argv, bool *thread_count_read,
 void adjust_thread_count(param_t *params);
 
 /*
- * Función de multiplicación para los hilos.
+ * Función de multiplicación para los hilos. Se
+ * ejecuta como trabajo del pool de hilos.
+ */
+void matrix_mult_thread(void *args);
+
+/*
+ * Multiplicación secuencial de C = A x B, con
+ * las matrices cuantizadas si no son nulas.
+ */
+void matrix_mult_sequential(matrix_t *mat_a, matrix_t *mat_b, qmatrix_t *qmat_a,
+		qmatrix_t *qmat_b, matrix_t *mat_c);
+
+/*
+ * Función de inicialización de las matrices para
+ * los hilos. Se ejecuta en cada hilo del pool antes
+ * de la multiplicación, de modo que las páginas de
+ * cada partición queden en el nodo NUMA del hilo
+ * que luego la procesa.
  */
-void *matrix_mult_thread(void *args);
+void matrix_init_thread(void *args);
+
+/*
+ * Retorna el nombre de un tipo de particionamiento.
+ */
+const char *distrib_name(int distrib_type);
 
 /*
  * Realiza la distribución de las matrices con
@@ -81,29 +173,117 @@ void *matrix_mult_thread(void *args);
 void distrib_1d(matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c, 
 		int thread_count, matrix_mult_args *arguments);
 
+/*
+ * Factoriza "thread_count" en una grilla de
+ * grid_rows x grid_cols hilos para una matriz C
+ * de rows x cols, con grid_rows <= rows y
+ * grid_cols <= cols, eligiendo la que mejor se
+ * ajusta a la forma de C. Retorna false si no
+ * existe tal grilla.
+ */
+bool grid_2d_shape(int rows, int cols, int thread_count, int *grid_rows, 
+		int *grid_cols);
+
 /*
  * Realiza la distribución de las matrices con
- * particionamiento 2-D (dos dimensiones).
+ * particionamiento 2-D (dos dimensiones), sobre
+ * una grilla de p x q hilos para cualquier
+ * cantidad de hilos.
  * El esquema de particionamiento de datos utilizado
  * es el de "Datos de Salida".
  */
 void distrib_2d(matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c, 
 		int thread_count, matrix_mult_args *arguments);
 
+/*
+ * Factoriza "thread_count" en una grilla de
+ * grid_rows x grid_cols x grid_depth hilos para
+ * C (rows x cols) += A (rows x depth) x B (depth x cols),
+ * sin superar ninguna de las dimensiones, eligiendo
+ * la que minimiza el tráfico de memoria por hilo
+ * (incluida la reducción de las C parciales).
+ * Retorna false si no existe tal grilla.
+ */
+bool grid_3d_shape(int rows, int cols, int depth, int thread_count, int *grid_rows,
+		int *grid_cols, int *grid_depth);
+
+/*
+ * Realiza la distribución de las matrices con
+ * particionamiento 3-D: además de las filas y
+ * columnas de C se divide la dimensión común. Cada
+ * grupo de hilos del mismo rango de la dimensión
+ * común acumula en su propia C parcial (el primero,
+ * en C), que luego se suman con reduce_partials().
+ */
+void distrib_3d(matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c, 
+		int thread_count, matrix_mult_args *arguments);
+
+/*
+ * Suma las C parciales de la distribución 3d sobre
+ * C, con una reducción en árbol repartida entre los
+ * hilos del pool. No hace nada con las demás
+ * distribuciones.
+ */
+void reduce_partials(pool_t *pool, matrix_mult_args *arguments, int thread_count);
+
+/*
+ * Libera lo asignado por la distribución (el
+ * planificador dinámico o las C parciales).
+ */
+void distrib_release(matrix_mult_args *arguments, int thread_count);
+
+/*
+ * Realiza la distribución dinámica de la matriz C
+ * en bloques, repartidos entre colas propias de
+ * cada hilo, con robo de trabajo entre hilos.
+ */
+void distrib_tiles(matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c, 
+		int thread_count, matrix_mult_args *arguments);
+
+/*
+ * Realiza la distribución indicada por "distrib_type"
+ * (1d, 2d, dinámica o 3d). El hilo "i" recibe la partición
+ * arguments[i].
+ */
+void distribute(int distrib_type, matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c, 
+		int thread_count, matrix_mult_args *arguments);
+
 /*
  * Imprime las matrices de entrada y salida en un
- * archivo de texto.
+ * archivo de texto, repartiendo la conversión entre
+ * los hilos de "pool" (si no es nulo).
  */
-void print_matrices(matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c);
+void print_matrices(matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c, pool_t *pool,
+		int thread_count);
 
 /*
- * Imprime los tiempos calculados.
+ * Imprime los tiempos calculados. Si "arguments" no
+ * es nulo, se agregan las estadísticas de los tiempos
+ * registrados por cada hilo (mínimo, máximo, promedio,
+ * desbalance y espera hasta el fin del lote).
+ * Se imprimen también las operaciones por segundo y,
+ * si "tiempo_base" (tiempo secuencial de referencia,
+ * en nanosegundos) es positivo, la aceleración y la
+ * eficiencia. Si "roof" no es nulo, se ubica la
+ * ejecución en el modelo "roofline" del equipo.
  */
 void print_times(time_rec_t tiempo_total_multip, time_rec_t tiempo_total_partit,
-			time_rec_t tiempo_total_thr_creat, time_rec_t tiempo_total_thr_exec,
-			int thread_count, matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c);
+			pool_stats_t despacho_pool, time_rec_t tiempo_total_thr_exec,
+			long long tiempo_base, const roofline_t *roof, 
+			matrix_mult_args *arguments, int thread_count, 
+			matrix_t *mat_a, matrix_t *mat_b, matrix_t *mat_c);
 
 /*
- * Imprime las particiones de cada hilo.
+ * Imprime las particiones de cada hilo. Con
+ * distribución dinámica se imprimen los bloques
+ * que efectivamente ejecutó cada hilo.
  */
 void print_partitions(matrix_mult_args *arguments, int thread_count);
+
+/*
+ * Imprime el procesador, núcleo, socket y nodo
+ * NUMA asignado a cada hilo.
+ */
+void print_placement(const cpu_topology_t *topo, const int *place, int thread_count);
+
+#endif /*CONFIG_H_*/
@@ -0,0 +1,114 @@
+#include "counters.h"
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/*
+ * Configuración de un evento de caché: caché,
+ * operación (lectura) y resultado (fallo).
+ */
+#define CACHE_EVENT(cache) ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | \
+		(PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+/*
+ * Tipo y configuración de cada contador.
+ */
+static const struct {
+	unsigned int type;
+	unsigned long long config;
+} events[COUNTER_COUNT] = {
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HW_CACHE, CACHE_EVENT(PERF_COUNT_HW_CACHE_L1D) },
+	{ PERF_TYPE_HW_CACHE, CACHE_EVENT(PERF_COUNT_HW_CACHE_LL) },
+	{ PERF_TYPE_HW_CACHE, CACHE_EVENT(PERF_COUNT_HW_CACHE_DTLB) },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+#endif
+
+static const char *names[COUNTER_COUNT] = {
+	"Ciclos", "Instrucciones", "FallosL1D", "FallosLLC", "FallosDTLB", "FallosSaltos"
+};
+
+const char *counter_name(counter_id_t id) {
+	return id >= 0 && id < COUNTER_COUNT ? names[id] : "desconocido";
+}
+
+bool counters_start(counter_set_t *set) {
+	bool alguno = false;
+	int i;
+	
+	for (i=0; i < COUNTER_COUNT; i++)
+		set->fds[i] = -1;
+	
+#ifdef __linux__
+	struct perf_event_attr attr;
+	
+	for (i=0; i < COUNTER_COUNT; i++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.size           = sizeof(attr);
+		attr.type           = events[i].type;
+		attr.config         = events[i].config;
+		attr.disabled       = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv     = 1;
+		attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		
+		// Hilo actual (pid 0), en cualquier procesador (cpu -1)
+		set->fds[i] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		if (set->fds[i] >= 0)
+			alguno = true;
+	}
+	
+	for (i=0; i < COUNTER_COUNT; i++)
+		if (set->fds[i] >= 0) {
+			ioctl(set->fds[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(set->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	
+	return alguno;
+}
+
+void counters_stop(counter_set_t *set, counters_t *counters) {
+	int i;
+	
+	for (i=0; i < COUNTER_COUNT; i++)
+		counters->values[i] = -1;
+	
+#ifdef __linux__
+	unsigned long long lectura[3];	// Valor, tiempo habilitado y en ejecución
+	
+	for (i=0; i < COUNTER_COUNT; i++)
+		if (set->fds[i] >= 0)
+			ioctl(set->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+	
+	for (i=0; i < COUNTER_COUNT; i++) {
+		if (set->fds[i] < 0)
+			continue;
+		
+		if (read(set->fds[i], lectura, sizeof(lectura)) == sizeof(lectura)) {
+			if (lectura[2] > 0 && lectura[2] < lectura[1])
+				counters->values[i] = (long long) ((double) lectura[0] * lectura[1] / lectura[2]);
+			else
+				counters->values[i] = (long long) lectura[0];
+		}
+		
+		close(set->fds[i]);
+		set->fds[i] = -1;
+	}
+#endif
+}
+
+void counters_add(counters_t *total, const counters_t *counters) {
+	int i;
+	
+	for (i=0; i < COUNTER_COUNT; i++) {
+		if (total->values[i] < 0 || counters->values[i] < 0)
+			total->values[i] = -1;
+		else
+			total->values[i] += counters->values[i];
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef COUNTERS_H_
+#define COUNTERS_H_
+
+#include "utils.h"
+
+/*
+ * Contadores de hardware (ver perf_event_open(2))
+ * que se miden en cada hilo.
+ */
+typedef enum {
+	COUNTER_CYCLES,
+	COUNTER_INSTRUCTIONS,
+	COUNTER_L1D_MISSES,
+	COUNTER_LLC_MISSES,
+	COUNTER_DTLB_MISSES,
+	COUNTER_BRANCH_MISSES,
+	COUNTER_COUNT
+} counter_id_t;
+
+/*
+ * Valores de los contadores de un hilo. Si el
+ * contador no pudo abrirse (sin soporte del
+ * procesador o sin permisos) su valor es -1. Si
+ * el núcleo multiplexó los contadores, el valor
+ * se escala según el tiempo que estuvo activo.
+ */
+typedef struct {
+	long long values[COUNTER_COUNT];
+} counters_t;
+
+/*
+ * Contadores abiertos por un hilo.
+ */
+typedef struct {
+	int fds[COUNTER_COUNT];
+} counter_set_t;
+
+/*
+ * Retorna el nombre de un contador.
+ */
+const char *counter_name(counter_id_t id);
+
+/*
+ * Abre y habilita los contadores para el hilo
+ * que la invoca (solo modo usuario). Retorna
+ * false si no pudo abrirse ninguno.
+ */
+bool counters_start(counter_set_t *set);
+
+/*
+ * Detiene y lee los contadores abiertos con
+ * counters_start(), y los cierra.
+ */
+void counters_stop(counter_set_t *set, counters_t *counters);
+
+/*
+ * Acumula en "total" los valores de "counters".
+ * Un contador no disponible en alguno de los dos
+ * queda no disponible.
+ */
+void counters_add(counters_t *total, const counters_t *counters);
+
+#endif /*COUNTERS_H_*/
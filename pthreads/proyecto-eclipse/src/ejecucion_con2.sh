@@ -1,26 +1,9 @@
 #!/bin/sh
 
-FILE=matrix-mult_tiempos
+FILE=matrix-mult_barrido
 
-for N in 400 800 1200 1600 2000 2400 2800 3200; do
-	for H in 1 4 9 16 36 64; do
-	echo "Ejecutando Concurrente $N 2d $H hilos"
-		for i in 1 2 3; do
-			./matrix-mult -a $N $N -b $N $N -h $H -t 2 -ni
-            
-            if test $N -lt 1000 then
-                if test $H -lt 10 then
-                    mv $FILE.csv $FILE-con1-0$N-0$H-$i.csv
-                else
-                    mv $FILE.csv $FILE-con1-0$N-$H-$i.csv
-                fi
-			else
-    			if test $H -lt 10 then
-                    mv $FILE.csv $FILE-con1-$N-0$H-$i.csv
-                else
-                    mv $FILE.csv $FILE-con1-$N-$H-$i.csv
-                fi
-			fi
-		done
-	done
-done
+echo "Ejecutando Concurrente 2d"
+./matrix-mult --sweep -s 400,800,1200,1600,2000,2400,2800,3200 -h 1,4,9,16,36,64 -t 2 -r 3
+
+mv $FILE.csv $FILE-con2.csv
+mv $FILE.json $FILE-con2.json
@@ -0,0 +1,276 @@
+#include "gemm.h"
+
+/*
+ * Buffers de empaquetado de un hilo.
+ */
+typedef struct {
+	void *pack_a;
+	void *pack_b;
+	size_t size_a;		// Bytes
+	size_t size_b;		// Bytes
+} gemm_workspace_t;
+
+/*
+ * Micro-núcleo portable.
+ */
+static void ukernel_scalar(int kc, const matrix_elem_t *a,
+		const matrix_elem_t *b, matrix_elem_t *c, int ldc) {
+	
+	matrix_elem_t ab[GEMM_SCALAR_MR][GEMM_SCALAR_NR] = {{0}};
+	int i, j, k;
+	
+	for (k=0; k < kc; k++) {
+		for (i=0; i < GEMM_SCALAR_MR; i++)
+		for (j=0; j < GEMM_SCALAR_NR; j++)
+			ab[i][j] += a[i] * b[j];
+		
+		a += GEMM_SCALAR_MR;
+		b += GEMM_SCALAR_NR;
+	}
+	
+	for (i=0; i < GEMM_SCALAR_MR; i++)
+	for (j=0; j < GEMM_SCALAR_NR; j++)
+		c[i * ldc + j] += ab[i][j];
+}
+
+static const gemm_kernel_t kernel_scalar = {
+	"escalar", GEMM_SCALAR_MR, GEMM_SCALAR_NR, ukernel_scalar
+};
+
+/*
+ * Micro-núcleo seleccionado.
+ */
+static const gemm_kernel_t *kernel = &kernel_scalar;
+
+/*
+ * Clave de los buffers de empaquetado de cada hilo.
+ */
+static pthread_key_t  workspace_key;
+static pthread_once_t workspace_once = PTHREAD_ONCE_INIT;
+
+static void workspace_destroy(void *ptr) {
+	gemm_workspace_t *ws = (gemm_workspace_t *) ptr;
+	
+	free(ws->pack_a);
+	free(ws->pack_b);
+	free(ws);
+}
+
+static void workspace_key_create(void) {
+	if (pthread_key_create(&workspace_key, workspace_destroy) != 0)
+		LOG(FATAL, "%s(): %s", __func__, "Error al crear la clave de los buffers.");
+}
+
+void gemm_workspace_get(size_t size_a, size_t size_b, void **pack_a, void **pack_b) {
+	gemm_workspace_t *ws;
+	
+	pthread_once(&workspace_once, workspace_key_create);
+	
+	if ((ws = pthread_getspecific(workspace_key)) == NULL) {
+		ws = GET_MEM(gemm_workspace_t, 1);
+		ws->pack_a = NULL;
+		ws->pack_b = NULL;
+		ws->size_a = 0;
+		ws->size_b = 0;
+		pthread_setspecific(workspace_key, ws);
+	}
+	
+	if (ws->size_a < size_a) {
+		free(ws->pack_a);
+		ws->pack_a = xmalloc_aligned(CACHE_LINE_SIZE, size_a);
+		ws->size_a = size_a;
+	}
+	
+	if (ws->size_b < size_b) {
+		free(ws->pack_b);
+		ws->pack_b = xmalloc_aligned(CACHE_LINE_SIZE, size_b);
+		ws->size_b = size_b;
+	}
+	
+	*pack_a = ws->pack_a;
+	*pack_b = ws->pack_b;
+}
+
+void gemm_workspace_release(void) {
+	gemm_workspace_t *ws;
+	
+	pthread_once(&workspace_once, workspace_key_create);
+	
+	if ((ws = pthread_getspecific(workspace_key)) != NULL) {
+		workspace_destroy(ws);
+		pthread_setspecific(workspace_key, NULL);
+	}
+}
+
+int gemm_kernels_available(const gemm_kernel_t **kernels, int max) {
+	cpu_features_t features;
+	int count = 0;
+	
+	cpu_features_read(&features);
+	
+	if (count < max)
+		kernels[count++] = &kernel_scalar;
+	
+#if defined(GEMM_X86) && defined(FLOAT)
+	if (features.avx2 && features.fma && count < max)
+		kernels[count++] = &gemm_kernel_avx2;
+	if (features.avx512f && count < max)
+		kernels[count++] = &gemm_kernel_avx512;
+#elif defined(GEMM_X86)
+	if (features.avx2 && count < max)
+		kernels[count++] = &gemm_kernel_avx2;
+	if (features.avx512f && count < max)
+		kernels[count++] = &gemm_kernel_avx512;
+#endif
+	
+	return count;
+}
+
+void gemm_init(void) {
+	const gemm_kernel_t *kernels[GEMM_MAX_KERNELS];
+	
+	// El último disponible es el más rápido
+	kernel = kernels[gemm_kernels_available(kernels, GEMM_MAX_KERNELS) - 1];
+}
+
+void gemm_kernel_set(const gemm_kernel_t *k) {
+	kernel = k;
+}
+
+const gemm_kernel_t *gemm_kernel_get(void) {
+	return kernel;
+}
+
+/*
+ * Empaqueta el bloque de mc x kc de A que comienza en
+ * (row, col) en paneles de mr filas. Cada panel almacena
+ * sus kc columnas una tras otra; las filas que faltan en
+ * el último panel se completan con ceros.
+ */
+static void pack_a(matrix_t *a, int row, int col, int mc, int kc, int mr,
+		matrix_elem_t *dest) {
+	
+	int ir, i, k, rows;
+	
+	for (ir=0; ir < mc; ir += mr) {
+		rows = MIN(mr, mc - ir);
+		
+		for (k=0; k < kc; k++) {
+			for (i=0; i < rows; i++)
+				dest[i] = matrix_val(a, row + ir + i, col + k);
+			for (; i < mr; i++)
+				dest[i] = 0;
+			
+			dest += mr;
+		}
+	}
+}
+
+/*
+ * Empaqueta el bloque de kc x nc de B que comienza en
+ * (row, col) en paneles de nr columnas. Cada panel almacena
+ * sus kc filas una tras otra; las columnas que faltan en
+ * el último panel se completan con ceros.
+ */
+static void pack_b(matrix_t *b, int row, int col, int kc, int nc, int nr,
+		matrix_elem_t *dest) {
+	
+	int jr, j, k, cols;
+	
+	for (jr=0; jr < nc; jr += nr) {
+		cols = MIN(nr, nc - jr);
+		
+		for (k=0; k < kc; k++) {
+			matrix_elem_t *b_row = matrix_row(b, row + k) + col + jr;
+			
+			for (j=0; j < cols; j++)
+				dest[j] = b_row[j];
+			for (; j < nr; j++)
+				dest[j] = 0;
+			
+			dest += nr;
+		}
+	}
+}
+
+/*
+ * Recorre el bloque de mc x nc de C que comienza en
+ * (row, col) invocando al micro-núcleo por cada
+ * sub-bloque de mr x nr. Los sub-bloques incompletos
+ * de los bordes se calculan en un bloque auxiliar y
+ * luego se suman a C.
+ */
+static void macro_kernel(const matrix_elem_t *pack_a, const matrix_elem_t *pack_b,
+		matrix_t *c, int row, int col, int mc, int nc, int kc) {
+	
+	int mr = kernel->mr, nr = kernel->nr;
+	int ir, jr, i, j, rows, cols;
+	matrix_elem_t tmp[GEMM_MAX_MR * GEMM_MAX_NR] __attribute__((aligned(CACHE_LINE_SIZE)));
+	
+	for (jr=0; jr < nc; jr += nr) {
+		cols = MIN(nr, nc - jr);
+		
+		for (ir=0; ir < mc; ir += mr) {
+			rows = MIN(mr, mc - ir);
+			
+			const matrix_elem_t *a_panel = pack_a + (size_t) ir * kc;
+			const matrix_elem_t *b_panel = pack_b + (size_t) jr * kc;
+			
+			if (rows == mr && cols == nr) {
+				kernel->fn(kc, a_panel, b_panel, 
+						&matrix_ref(c, row + ir, col + jr), matrix_ld(c));
+			}
+			else {
+				memset(tmp, 0, sizeof(tmp));
+				kernel->fn(kc, a_panel, b_panel, tmp, nr);
+				
+				for (i=0; i < rows; i++)
+				for (j=0; j < cols; j++)
+					matrix_ref(c, row + ir + i, col + jr + j) += tmp[i * nr + j];
+			}
+		}
+	}
+}
+
+void gemm_mult(matrix_t *a, matrix_t *b, matrix_t *c,
+		int row_begin, int row_count, int col_begin, int col_count) {
+	
+	matrix_tiles_t t = matrix_tiles_get();
+	int mr = kernel->mr, nr = kernel->nr;
+	int ic, jc, pc, mc, nc, kc;
+	int row_end = row_begin + row_count;
+	int col_end = col_begin + col_count;
+	int k_end   = matrix_cols(a);
+	matrix_elem_t *buf_a, *buf_b;
+	
+	if (row_count <= 0 || col_count <= 0)
+		return;
+	
+	/*
+	 * Los buffers se dimensionan para el mayor bloque
+	 * que efectivamente recorre este hilo, redondeado
+	 * a paneles completos.
+	 */
+	mc = MIN(t.mc, row_count);
+	nc = MIN(t.nc, col_count);
+	kc = MIN(t.kc, k_end);
+	gemm_workspace_get((size_t) (mc + mr - 1) / mr * mr * kc * sizeof(matrix_elem_t),
+					   (size_t) (nc + nr - 1) / nr * nr * kc * sizeof(matrix_elem_t),
+					   (void **) &buf_a, (void **) &buf_b);
+	
+	for (jc=col_begin; jc < col_end; jc += t.nc) {
+		nc = MIN(t.nc, col_end - jc);
+		
+		for (pc=0; pc < k_end; pc += t.kc) {
+			kc = MIN(t.kc, k_end - pc);
+			pack_b(b, pc, jc, kc, nc, nr, buf_b);
+			
+			for (ic=row_begin; ic < row_end; ic += t.mc) {
+				mc = MIN(t.mc, row_end - ic);
+				pack_a(a, ic, pc, mc, kc, mr, buf_a);
+				
+				macro_kernel(buf_a, buf_b, c, ic, jc, mc, nc, kc);
+			}
+		}
+	}
+}
@@ -0,0 +1,112 @@
+#ifndef GEMM_H_
+#define GEMM_H_
+
+#include "matrix.h"
+
+/*
+ * Dimensiones del micro-núcleo portable.
+ */
+#define GEMM_SCALAR_MR 4
+#define GEMM_SCALAR_NR 8
+
+/*
+ * Máximas dimensiones de un micro-núcleo.
+ */
+#define GEMM_MAX_MR 16
+#define GEMM_MAX_NR 32
+
+/*
+ * Función de micro-núcleo. Acumula en el bloque de
+ * MR x NR de C (con dimensión principal ldc) el
+ * producto de un panel de A (kc columnas de MR
+ * elementos) por un panel de B (kc filas de NR
+ * elementos), ambos empaquetados en forma contigua.
+ * El bloque de C se mantiene en registros durante
+ * todo el lazo de k.
+ */
+typedef void (*gemm_ukernel_fn)(int kc, const matrix_elem_t *a,
+		const matrix_elem_t *b, matrix_elem_t *c, int ldc);
+
+/*
+ * Descriptor de un micro-núcleo.
+ */
+typedef struct {
+	const char *name;
+	int mr;
+	int nr;
+	gemm_ukernel_fn fn;
+} gemm_kernel_t;
+
+/*
+ * Micro-núcleos vectoriales (ver gemm_avx2.c y
+ * gemm_avx512.c), compilados solo en x86.
+ */
+#ifdef GEMM_X86
+extern const gemm_kernel_t gemm_kernel_avx2;
+extern const gemm_kernel_t gemm_kernel_avx512;
+#endif
+
+/*
+ * Máxima cantidad de micro-núcleos.
+ */
+#define GEMM_MAX_KERNELS 4
+
+/*
+ * Guarda en "kernels" (a lo sumo "max") los
+ * micro-núcleos que puede ejecutar el procesador,
+ * del portable al más rápido, y retorna su cantidad
+ * (al menos uno, el portable).
+ */
+int gemm_kernels_available(const gemm_kernel_t **kernels, int max);
+
+/*
+ * Selecciona el micro-núcleo a utilizar según las
+ * extensiones SIMD detectadas en tiempo de ejecución.
+ * El micro-núcleo portable se utiliza si no hay uno
+ * vectorial aplicable.
+ */
+void gemm_init(void);
+
+/*
+ * Retorna el micro-núcleo seleccionado.
+ */
+const gemm_kernel_t *gemm_kernel_get(void);
+
+/*
+ * Establece el micro-núcleo a utilizar (por ejemplo,
+ * para comparar los disponibles). Debe ser uno de
+ * los retornados por gemm_kernels_available().
+ */
+void gemm_kernel_set(const gemm_kernel_t *k);
+
+/*
+ * Multiplicación con paneles empaquetados. Misma
+ * semántica que matrix_mult(): acumula en C el bloque
+ * de filas [row_begin, row_begin + row_count) y columnas
+ * [col_begin, col_begin + col_count) de A x B.
+ * 
+ * Cada hilo empaqueta su porción de A y B en buffers
+ * propios, que se asignan en su primera llamada y se
+ * reutilizan en las siguientes. Se liberan al terminar
+ * el hilo o con gemm_workspace_release().
+ */
+void gemm_mult(matrix_t *a, matrix_t *b, matrix_t *c,
+		int row_begin, int row_count, int col_begin, int col_count);
+
+/*
+ * Obtiene los buffers de empaquetado del hilo que
+ * la invoca, alineados a una línea de caché y con
+ * capacidad para al menos size_a y size_b bytes.
+ * Los buffers se agrandan si hace falta y se
+ * reutilizan en las llamadas siguientes.
+ */
+void gemm_workspace_get(size_t size_a, size_t size_b, void **pack_a, void **pack_b);
+
+/*
+ * Libera los buffers de empaquetado del hilo que
+ * la invoca (necesario para el hilo principal, en
+ * el que no se ejecuta el destructor de los hilos).
+ */
+void gemm_workspace_release(void);
+
+#endif /*GEMM_H_*/
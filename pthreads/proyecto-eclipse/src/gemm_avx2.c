@@ -0,0 +1,146 @@
+#include "quant.h"
+
+/*
+ * Micro-núcleos AVX2. Este módulo se compila con
+ * -mavx2 -mfma y solo se invoca si cpu_features_read()
+ * detecta las extensiones.
+ */
+#ifdef GEMM_X86
+#include <immintrin.h>
+
+#ifdef FLOAT
+/*
+ * Micro-núcleo de 6 x 16 para float: cada fila del
+ * bloque de C ocupa dos registros YMM (12 acumuladores),
+ * más dos registros para la fila de B y uno para el
+ * elemento de A difundido.
+ */
+static void ukernel_avx2(int kc, const matrix_elem_t *a,
+		const matrix_elem_t *b, matrix_elem_t *c, int ldc) {
+	
+	__m256 acc[6][2];
+	__m256 b0, b1, ai;
+	int i, k;
+	
+	#pragma GCC unroll 6
+	for (i=0; i < 6; i++) {
+		acc[i][0] = _mm256_setzero_ps();
+		acc[i][1] = _mm256_setzero_ps();
+	}
+	
+	for (k=0; k < kc; k++) {
+		b0 = _mm256_load_ps(b);
+		b1 = _mm256_load_ps(b + 8);
+		
+		#pragma GCC unroll 6
+		for (i=0; i < 6; i++) {
+			ai = _mm256_broadcast_ss(a + i);
+			acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+			acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+		}
+		
+		a += 6;
+		b += 16;
+	}
+	
+	#pragma GCC unroll 6
+	for (i=0; i < 6; i++) {
+		matrix_elem_t *c_row = c + i * ldc;
+		
+		_mm256_storeu_ps(c_row,     _mm256_add_ps(_mm256_loadu_ps(c_row), acc[i][0]));
+		_mm256_storeu_ps(c_row + 8, _mm256_add_ps(_mm256_loadu_ps(c_row + 8), acc[i][1]));
+	}
+}
+#else
+/*
+ * Micro-núcleo de 6 x 16 para unsigned int, con la
+ * misma distribución de registros que el de float,
+ * usando vpmulld y vpaddd (aritmética módulo 2^32).
+ */
+static void ukernel_avx2(int kc, const matrix_elem_t *a,
+		const matrix_elem_t *b, matrix_elem_t *c, int ldc) {
+	
+	__m256i acc[6][2];
+	__m256i b0, b1, ai;
+	int i, k;
+	
+	#pragma GCC unroll 6
+	for (i=0; i < 6; i++) {
+		acc[i][0] = _mm256_setzero_si256();
+		acc[i][1] = _mm256_setzero_si256();
+	}
+	
+	for (k=0; k < kc; k++) {
+		b0 = _mm256_load_si256((const __m256i *) b);
+		b1 = _mm256_load_si256((const __m256i *) (b + 8));
+		
+		#pragma GCC unroll 6
+		for (i=0; i < 6; i++) {
+			ai = _mm256_set1_epi32(a[i]);
+			acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_mullo_epi32(ai, b0));
+			acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_mullo_epi32(ai, b1));
+		}
+		
+		a += 6;
+		b += 16;
+	}
+	
+	#pragma GCC unroll 6
+	for (i=0; i < 6; i++) {
+		__m256i *c_row = (__m256i *) (c + i * ldc);
+		
+		_mm256_storeu_si256(c_row,     _mm256_add_epi32(_mm256_loadu_si256(c_row), acc[i][0]));
+		_mm256_storeu_si256(c_row + 1, _mm256_add_epi32(_mm256_loadu_si256(c_row + 1), acc[i][1]));
+	}
+}
+#endif
+
+const gemm_kernel_t gemm_kernel_avx2 = {
+	"avx2", 6, 16, ukernel_avx2
+};
+
+/*
+ * Micro-núcleo cuantizado de 6 x 16: cada registro
+ * de B contiene 8 pares de 16 bits, y vpmaddwd los
+ * multiplica por el par de A difundido y suma cada
+ * par en un entero de 32 bits.
+ */
+static void qkernel_avx2(int kp, const int16_t *a, const int16_t *b, int32_t *c) {
+	__m256i acc[6][2];
+	__m256i b0, b1, ai;
+	int32_t par;
+	int i, p;
+	
+	#pragma GCC unroll 6
+	for (i=0; i < 6; i++) {
+		acc[i][0] = _mm256_setzero_si256();
+		acc[i][1] = _mm256_setzero_si256();
+	}
+	
+	for (p=0; p < kp; p++) {
+		b0 = _mm256_load_si256((const __m256i *) b);
+		b1 = _mm256_load_si256((const __m256i *) (b + 16));
+		
+		#pragma GCC unroll 6
+		for (i=0; i < 6; i++) {
+			memcpy(&par, a + 2 * i, sizeof(par));
+			ai = _mm256_set1_epi32(par);
+			acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_madd_epi16(ai, b0));
+			acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_madd_epi16(ai, b1));
+		}
+		
+		a += 2 * 6;
+		b += 2 * 16;
+	}
+	
+	#pragma GCC unroll 6
+	for (i=0; i < 6; i++) {
+		_mm256_store_si256((__m256i *) (c + i * 16),     acc[i][0]);
+		_mm256_store_si256((__m256i *) (c + i * 16 + 8), acc[i][1]);
+	}
+}
+
+const quant_kernel_t quant_kernel_avx2 = {
+	"avx2", 6, 16, qkernel_avx2
+};
+#endif
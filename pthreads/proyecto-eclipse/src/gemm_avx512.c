@@ -0,0 +1,146 @@
+#include "quant.h"
+
+/*
+ * Micro-núcleos AVX-512. Este módulo se compila con
+ * -mavx512f -mavx512bw y solo se invoca si
+ * cpu_features_read() detecta las extensiones.
+ */
+#ifdef GEMM_X86
+#include <immintrin.h>
+
+#ifdef FLOAT
+/*
+ * Micro-núcleo de 12 x 32 para float: cada fila del
+ * bloque de C ocupa dos registros ZMM (24 acumuladores),
+ * más dos registros para la fila de B y uno para el
+ * elemento de A difundido.
+ */
+static void ukernel_avx512(int kc, const matrix_elem_t *a,
+		const matrix_elem_t *b, matrix_elem_t *c, int ldc) {
+	
+	__m512 acc[12][2];
+	__m512 b0, b1, ai;
+	int i, k;
+	
+	#pragma GCC unroll 12
+	for (i=0; i < 12; i++) {
+		acc[i][0] = _mm512_setzero_ps();
+		acc[i][1] = _mm512_setzero_ps();
+	}
+	
+	for (k=0; k < kc; k++) {
+		b0 = _mm512_load_ps(b);
+		b1 = _mm512_load_ps(b + 16);
+		
+		#pragma GCC unroll 12
+		for (i=0; i < 12; i++) {
+			ai = _mm512_set1_ps(a[i]);
+			acc[i][0] = _mm512_fmadd_ps(ai, b0, acc[i][0]);
+			acc[i][1] = _mm512_fmadd_ps(ai, b1, acc[i][1]);
+		}
+		
+		a += 12;
+		b += 32;
+	}
+	
+	#pragma GCC unroll 12
+	for (i=0; i < 12; i++) {
+		matrix_elem_t *c_row = c + i * ldc;
+		
+		_mm512_storeu_ps(c_row,      _mm512_add_ps(_mm512_loadu_ps(c_row), acc[i][0]));
+		_mm512_storeu_ps(c_row + 16, _mm512_add_ps(_mm512_loadu_ps(c_row + 16), acc[i][1]));
+	}
+}
+#else
+/*
+ * Micro-núcleo de 12 x 32 para unsigned int, con la
+ * misma distribución de registros que el de float,
+ * usando vpmulld y vpaddd (aritmética módulo 2^32).
+ */
+static void ukernel_avx512(int kc, const matrix_elem_t *a,
+		const matrix_elem_t *b, matrix_elem_t *c, int ldc) {
+	
+	__m512i acc[12][2];
+	__m512i b0, b1, ai;
+	int i, k;
+	
+	#pragma GCC unroll 12
+	for (i=0; i < 12; i++) {
+		acc[i][0] = _mm512_setzero_si512();
+		acc[i][1] = _mm512_setzero_si512();
+	}
+	
+	for (k=0; k < kc; k++) {
+		b0 = _mm512_load_si512(b);
+		b1 = _mm512_load_si512(b + 16);
+		
+		#pragma GCC unroll 12
+		for (i=0; i < 12; i++) {
+			ai = _mm512_set1_epi32(a[i]);
+			acc[i][0] = _mm512_add_epi32(acc[i][0], _mm512_mullo_epi32(ai, b0));
+			acc[i][1] = _mm512_add_epi32(acc[i][1], _mm512_mullo_epi32(ai, b1));
+		}
+		
+		a += 12;
+		b += 32;
+	}
+	
+	#pragma GCC unroll 12
+	for (i=0; i < 12; i++) {
+		matrix_elem_t *c_row = c + i * ldc;
+		
+		_mm512_storeu_si512(c_row,      _mm512_add_epi32(_mm512_loadu_si512(c_row), acc[i][0]));
+		_mm512_storeu_si512(c_row + 16, _mm512_add_epi32(_mm512_loadu_si512(c_row + 16), acc[i][1]));
+	}
+}
+#endif
+
+const gemm_kernel_t gemm_kernel_avx512 = {
+	"avx512", 12, 32, ukernel_avx512
+};
+
+/*
+ * Micro-núcleo cuantizado de 12 x 32: cada registro
+ * de B contiene 16 pares de 16 bits, y vpmaddwd los
+ * multiplica por el par de A difundido y suma cada
+ * par en un entero de 32 bits. Requiere AVX-512BW.
+ */
+static void qkernel_avx512(int kp, const int16_t *a, const int16_t *b, int32_t *c) {
+	__m512i acc[12][2];
+	__m512i b0, b1, ai;
+	int32_t par;
+	int i, p;
+	
+	#pragma GCC unroll 12
+	for (i=0; i < 12; i++) {
+		acc[i][0] = _mm512_setzero_si512();
+		acc[i][1] = _mm512_setzero_si512();
+	}
+	
+	for (p=0; p < kp; p++) {
+		b0 = _mm512_load_si512(b);
+		b1 = _mm512_load_si512(b + 32);
+		
+		#pragma GCC unroll 12
+		for (i=0; i < 12; i++) {
+			memcpy(&par, a + 2 * i, sizeof(par));
+			ai = _mm512_set1_epi32(par);
+			acc[i][0] = _mm512_add_epi32(acc[i][0], _mm512_madd_epi16(ai, b0));
+			acc[i][1] = _mm512_add_epi32(acc[i][1], _mm512_madd_epi16(ai, b1));
+		}
+		
+		a += 2 * 12;
+		b += 2 * 32;
+	}
+	
+	#pragma GCC unroll 12
+	for (i=0; i < 12; i++) {
+		_mm512_store_si512(c + i * 32,      acc[i][0]);
+		_mm512_store_si512(c + i * 32 + 16, acc[i][1]);
+	}
+}
+
+const quant_kernel_t quant_kernel_avx512 = {
+	"avx512", 12, 32, qkernel_avx512
+};
+#endif
@@ -1,22 +1,53 @@
 #include "config.h"
+#include "sweep.h"
+#include "model.h"
 
 /*
  * Función principal del programa.
  */
 int main(int argc, char **argv) {
 	matrix_t *mat_a, *mat_b, *mat_c;
+	qmatrix_t *qmat_a = NULL, *qmat_b = NULL;
+	morton_t *zmat_a = NULL, *zmat_b = NULL, *zmat_c = NULL;
+	matrix_mult_args *arguments = NULL;
 	int i;
 	param_t params = {0};
 	bool thread_count_read = false;
 	bool print_output = true;
 	
+	pool_t *pool = NULL;
+	strassen_t *strassen = NULL;
+	cpu_topology_t topo = {0};
+	int *place = NULL;
+	
 	// Variables para control de tiempo
 	time_rec_t tiempo_total_multip    = {0};
 	time_rec_t tiempo_total_partit    = {0};
-	time_rec_t tiempo_total_thr_creat = {0};
 	time_rec_t tiempo_total_thr_exec  = {0};
+	pool_stats_t despacho_pool        = {0};
+	time_rec_t tiempo_base_sec        = {0};
+	long long tiempo_base             = 0;
+	baseline_key_t base_key;
+	roofline_t roof;
+	model_plan_t plan = {0};
+	stream_t *stream = NULL;
+	time_rec_t tiempo_total_salida    = {0};
 	
 	
+	/*
+	 * Modo barrido: múltiples tamaños, cantidades
+	 * de hilos y particionamientos en una sola
+	 * ejecución.
+	 */
+	if (sweep_requested(argc, argv)) {
+		sweep_t sweep;
+		
+		sweep_params(&sweep, argc, argv);
+		sweep_run(&sweep);
+		
+		return EXIT_SUCCESS;
+	}
+	
 	/*
 	 * Verificamos si se pasó como argumento
 	 * algún archivo de configuración, y 
@@ -24,6 +55,48 @@ int main(int argc, char **argv) {
 	 */
 	set_params(&params, argc, argv, &thread_count_read, &print_output);
 	
+	/*
+	 * La multiplicación cuantizada recorre toda la
+	 * dimensión común, por lo que no admite 3d.
+	 */
+	if (params.quant_bits > 0 && params.distrib_type == 4) {
+		LOG(INFO, "El particionamiento 3d no aplica con -q, se usa 2d.");
+		params.distrib_type = 2;
+	}
+	
+	/*
+	 * El modelo de -t auto describe la multiplicación
+	 * clásica con el micro-núcleo seleccionado.
+	 */
+	if (params.distrib_auto && (params.quant_bits > 0 || params.strassen_cutoff > 0 ||
+			params.layout == LAYOUT_MORTON)) {
+		LOG(INFO, "El particionamiento automático no aplica con -q, -sw ni -l morton, se usa 2d.");
+		params.distrib_auto = false;
+	}
+	
+	/*
+	 * Tamaños de bloque de la multiplicación,
+	 * según las cachés o los indicados por
+	 * línea de comandos.
+	 */
+	matrix_tiles_init(params.tile_kc, params.tile_mc, params.tile_nc);
+	LOG(INFO, "Tamaños de bloque: kc=%d, mc=%d, nc=%d.", matrix_tiles_get().kc,
+			matrix_tiles_get().mc, matrix_tiles_get().nc);
+	
+	/*
+	 * Selección del micro-núcleo de multiplicación.
+	 */
+	gemm_init();
+	
+	/*
+	 * Techos del modelo "roofline" del equipo (se
+	 * calibran una sola vez). No aplica a la
+	 * multiplicación cuantizada, que usa otro
+	 * micro-núcleo.
+	 */
+	if (params.quant_bits == 0)
+		roofline_get(&roof);
+	
 
 	/*
 	 * Verificamos que la cantidad de columnas
@@ -33,133 +106,487 @@ int main(int argc, char **argv) {
 		LOG(FATAL, "%s %s", "La cantidad de filas de la matriz A debe ser",
 				"igual a la cantidad de filas de la matriz B.");
 		
+	/*
+	 * Multiplicación concurrente. La cantidad de hilos se
+	 * debe ajustar apropiadamente. Los hilos del pool se
+	 * crean una sola vez, fuera de la región medida; cada
+	 * multiplicación solo paga el despacho de sus trabajos.
+	 */
+	if (thread_count_read) {
+		/*
+		 * Con -t auto, el modelo elige particionamiento,
+		 * grilla y cantidad de hilos (a lo sumo la
+		 * indicada) para estas dimensiones.
+		 */
+		if (params.distrib_auto) {
+			model_choose(&roof, params.matrix_a_fil, params.matrix_a_col, 
+					params.matrix_b_col, MIN(params.thread_count, MAX_THREADS), &plan);
+			
+			params.thread_count = plan.thread_count;
+			params.distrib_type = plan.distrib_type;
+			
+			LOG(INFO, "Modelo: particionamiento %s con %d hilo(s), grilla de %dx%dx%d.",
+					distrib_name(plan.distrib_type), plan.thread_count, plan.grid_rows,
+					plan.grid_cols, plan.grid_depth);
+			LOG(INFO, "Modelo: cómputo %.3f ms, memoria %.3f ms, reducción %.3f ms, "
+					"despacho %.3f ms.", NANOS_TO_MILLIS(plan.compute), 
+					NANOS_TO_MILLIS(plan.memory), NANOS_TO_MILLIS(plan.reduction),
+					NANOS_TO_MILLIS(plan.overhead));
+		}
+		
+		adjust_thread_count(&params);
+		pool_create(&pool, params.thread_count);
+	}
+	else
+		params.affinity = false;
+	
+	/*
+	 * Si se solicitó, fijamos cada hilo del pool a
+	 * un procesador, repartiéndolos entre los nodos
+	 * NUMA.
+	 */
+	if (params.affinity) {
+		if (!cpu_topology_read(&topo)) {
+			LOG(WARN, "No se pudo leer la topología. Los hilos no se fijarán.");
+			params.affinity = false;
+		}
+		else {
+			place = GET_MEM(int, params.thread_count);
+			cpu_topology_place(&topo, params.thread_count, place);
+			
+			for (i=0; i < params.thread_count; i++)
+				if (!pool_pin(pool, i, topo.cpus[place[i]].cpu))
+					LOG(WARN, "No se pudo fijar el hilo %d al procesador %d.", 
+							i, topo.cpus[place[i]].cpu);
+			
+			LOG(INFO, "Hilos fijados en %d procesador(es) de %d nodo(s) NUMA.", 
+					topo.cpu_count, topo.node_count);
+		}
+	}
+	
+	/*
+	 * Multiplicación fuera de memoria: A y B se leen
+	 * por franjas de sus archivos y C se guarda por
+	 * bloques, sin crear las matrices completas.
+	 */
+	if (params.ooc_budget > 0) {
+		ooc_plan_t ooc_recorrido;
+		ooc_stats_t ooc_medidas;
+		
+		if (params.quant_bits > 0 || params.strassen_cutoff > 0 || 
+				params.layout == LAYOUT_MORTON || params.stream)
+			LOG(INFO, "La multiplicación fuera de memoria no aplica -q, -sw, -l morton "
+					"ni --stream.");
+		
+		LOG(INFO, "Multiplicación fuera de memoria con %d hilo(s) y %zu MiB de buffers.",
+				params.thread_count, params.ooc_budget >> 20);
+		ooc_mult(params.file_a, params.file_b, params.file_c, params.ooc_budget, pool, 
+				params.thread_count, &ooc_recorrido, &ooc_medidas);
+		
+		LOG(INFO, "Bloques de C de %dx%d (grilla de %dx%d), franjas de %d (%d), %lld paso(s), "
+				"%.1f MiB de buffers.", ooc_recorrido.mb, ooc_recorrido.nb, 
+				ooc_recorrido.row_panels, ooc_recorrido.col_panels, ooc_recorrido.kb, 
+				ooc_recorrido.depth_panels, ooc_recorrido.steps, 
+				ooc_recorrido.memory / (1024.0 * 1024.0));
+		LOG(INFO, "Leídos %.1f MiB (estimado %.1f MiB), escritos %.1f MiB.",
+				ooc_medidas.read_bytes / (1024.0 * 1024.0), 
+				ooc_recorrido.read_bytes / (1024.0 * 1024.0),
+				ooc_medidas.written_bytes / (1024.0 * 1024.0));
+		LOG(INFO, "Tiempo total %.3f ms: cómputo %.3f ms, espera de lecturas %.3f ms, "
+				"de escrituras %.3f ms (lector %.3f ms, escritor %.3f ms).",
+				NANOS_TO_MILLIS(ooc_medidas.total), NANOS_TO_MILLIS(ooc_medidas.compute),
+				NANOS_TO_MILLIS(ooc_medidas.read_wait), NANOS_TO_MILLIS(ooc_medidas.write_wait),
+				NANOS_TO_MILLIS(ooc_medidas.read), NANOS_TO_MILLIS(ooc_medidas.write));
+		LOG(INFO, "%.3f %s.", 2.0 * params.matrix_a_fil * params.matrix_a_col * 
+				params.matrix_b_col / MAX(ooc_medidas.total, 1), MATRIX_OPS_UNIT);
+		
+		if (pool != NULL)
+			pool_destroy(pool);
+		if (place != NULL) {
+			free(place);
+			cpu_topology_free(&topo);
+		}
+		gemm_workspace_release();
+		
+		return EXIT_SUCCESS;
+	}
+	
 	/*
 	 * Creamos las matrices A, B y C.
 	 */
 	LOG(INFO, "Creando matrices.");
-	matrix_create(&mat_a, params.matrix_a_fil, params.matrix_a_col);
-	matrix_create(&mat_b, params.matrix_b_fil, params.matrix_b_col);
-	matrix_create(&mat_c, matrix_rows(mat_a), matrix_cols(mat_b));
+	matrix_hugepages_set(params.hugepages);
+	
+	if (params.affinity || (params.hugepages && pool != NULL)) {
+		/*
+		 * Cada hilo escribe por primera vez (y así ubica
+		 * en su nodo NUMA) la partición de C que luego
+		 * calcula, las filas de A que lee y una franja
+		 * de B, fuera de la región medida. Con páginas
+		 * grandes, además, los fallos de página se
+		 * atienden en paralelo y no durante la
+		 * multiplicación.
+		 */
+		if (params.file_a != NULL)
+			matrix_file_load(&mat_a, params.file_a, pool, params.thread_count);
+		else
+			matrix_alloc(&mat_a, params.matrix_a_fil, params.matrix_a_col);
+		if (params.file_b != NULL)
+			matrix_file_load(&mat_b, params.file_b, pool, params.thread_count);
+		else
+			matrix_alloc(&mat_b, params.matrix_b_fil, params.matrix_b_col);
+		matrix_alloc(&mat_c, matrix_rows(mat_a), matrix_cols(mat_b));
+		
+		matrix_mult_args *partitions = GET_MEM(matrix_mult_args, params.thread_count);
+		matrix_init_args *init = GET_MEM(matrix_init_args, params.thread_count);
+		unsigned int seed = (unsigned int) time(NULL);
+		
+		memset(partitions, 0, params.thread_count * sizeof(matrix_mult_args));
+		distribute(params.distrib_type, mat_a, mat_b, mat_c, params.thread_count, 
+				partitions);
+		
+		for (i=0; i < params.thread_count; i++) {
+			init[i].partition    = &partitions[i];
+			init[i].matrix_a     = params.file_a == NULL ? mat_a : NULL;
+			init[i].matrix_b     = params.file_b == NULL ? mat_b : NULL;
+			init[i].thread_count = params.thread_count;
+			init[i].seed_a       = seed;
+			init[i].seed_b       = ~seed;
+			
+			pool_submit_to(pool, i, matrix_init_thread, &init[i]);
+		}
+		pool_wait(pool);
+		
+		distrib_release(partitions, params.thread_count);
+		free(partitions);
+		free(init);
+	}
+	else {
+		if (params.file_a != NULL)
+			matrix_file_load(&mat_a, params.file_a, pool, params.thread_count);
+		else
+			matrix_create(&mat_a, params.matrix_a_fil, params.matrix_a_col);
+		if (params.file_b != NULL)
+			matrix_file_load(&mat_b, params.file_b, pool, params.thread_count);
+		else
+			matrix_create(&mat_b, params.matrix_b_fil, params.matrix_b_col);
+		matrix_create(&mat_c, matrix_rows(mat_a), matrix_cols(mat_b));
+		
+		/*
+		 * Cargamos las matrices que no se leyeron
+		 * de archivos con valores aleatorios.
+		 */
+		if (params.file_a == NULL)
+			matrix_fill(mat_a);
+		if (params.file_b == NULL)
+			matrix_fill(mat_b);
+	}
+	
+	if (params.hugepages)
+		LOG(INFO, "Matrices A, B y C en %s, %s y %s.", matrix_storage_name(mat_a),
+				matrix_storage_name(mat_b), matrix_storage_name(mat_c));
 	
 	/*
-	 * Cargamos las matrices con valores
-	 * aleatorios.
+	 * Si se solicitó, almacenamos A y B
+	 * cuantizadas con enteros de 8 o 16 bits.
 	 */
-	matrix_fill(mat_a);
-	matrix_fill(mat_b);
+	if (params.quant_bits > 0) {
+		LOG(INFO, "Cuantizando matrices A y B a %d bits.", params.quant_bits);
+		quant_init(params.quant_bits);
+		
+		qmatrix_create(&qmat_a, params.quant_bits, matrix_rows(mat_a), matrix_cols(mat_a));
+		qmatrix_create(&qmat_b, params.quant_bits, matrix_rows(mat_b), matrix_cols(mat_b));
+		
+		if (qmatrix_from_matrix(qmat_a, mat_a) + qmatrix_from_matrix(qmat_b, mat_b) > 0)
+			LOG(INFO, "Algunos elementos se saturaron al cuantizar.");
+		
+		if (params.strassen_cutoff > 0) {
+			LOG(INFO, "Strassen-Winograd no aplica a matrices cuantizadas.");
+			params.strassen_cutoff = 0;
+		}
+	}
 	
+	/*
+	 * Si se solicitó la disposición Morton, A y B se
+	 * convierten aquí (y C al terminar), fuera de la
+	 * región medida.
+	 */
+	if (params.layout == LAYOUT_MORTON && (params.quant_bits > 0 || 
+			params.strassen_cutoff > 0)) {
+		LOG(INFO, "La disposición Morton no aplica con -q ni -sw, se usa por filas.");
+		params.layout = LAYOUT_ROWS;
+	}
+	
+	if (params.layout == LAYOUT_MORTON) {
+		LOG(INFO, "Convirtiendo matrices A y B a disposición Morton.");
+		morton_create(&zmat_a, matrix_rows(mat_a), matrix_cols(mat_a));
+		morton_create(&zmat_b, matrix_rows(mat_b), matrix_cols(mat_b));
+		morton_create(&zmat_c, matrix_rows(mat_c), matrix_cols(mat_c));
+		
+		morton_from_matrix(zmat_a, mat_a, pool, params.thread_count);
+		morton_from_matrix(zmat_b, mat_b, pool, params.thread_count);
+		LOG(INFO, "Bloques Morton de C: %dx%d elementos, grilla de %dx%d.", 
+				zmat_c->tile_rows, zmat_c->tile_cols, zmat_c->grid_rows, zmat_c->grid_cols);
+	}
+	
+	/*
+	 * Tiempo secuencial de referencia para la aceleración
+	 * y la eficiencia. Si no está guardado para este
+	 * procesador y tamaño, se mide (fuera de la región
+	 * medida) sobre una matriz C auxiliar.
+	 */
+	baseline_key_init(&base_key, matrix_rows(mat_a), matrix_cols(mat_a), 
+			matrix_cols(mat_b), params.quant_bits);
+	
+	if ((thread_count_read || params.strassen_cutoff > 0 || zmat_c != NULL) && 
+			!baseline_load(&base_key, &tiempo_base)) {
+		matrix_t *mat_base;
+		
+		LOG(INFO, "Midiendo multiplicación secuencial de referencia.");
+		matrix_create(&mat_base, matrix_rows(mat_c), matrix_cols(mat_c));
+		
+		TIME_BEGIN(tiempo_base_sec);
+		matrix_mult_sequential(mat_a, mat_b, qmat_a, qmat_b, mat_base);
+		TIME_END(tiempo_base_sec);
+		
+		tiempo_base = TIME_DIFF(tiempo_base_sec);
+		baseline_store(&base_key, tiempo_base);
+		matrix_destroy(mat_base);
+	}
+	
+	/*
+	 * Strassen-Winograd: el espacio de trabajo se
+	 * asigna fuera de la región medida.
+	 */
+	if (params.strassen_cutoff > 0) {
+		strassen_create(&strassen, pool, params.thread_count, matrix_rows(mat_a), 
+				matrix_cols(mat_a), matrix_cols(mat_b), params.strassen_cutoff);
+		LOG(INFO, "Strassen-Winograd: %d nivel(es), corte %d, núcleo de %dx%dx%d.",
+				strassen->levels, strassen->cutoff, strassen->m0, strassen->k0, 
+				strassen->n0);
+	}
+	
+	/*
+	 * La escritura en flujo recibe las filas de C de
+	 * las particiones de la multiplicación concurrente
+	 * clásica, que no deben dividir la dimensión común.
+	 */
+	if (params.stream && (!print_output || !thread_count_read || strassen != NULL || 
+			zmat_c != NULL || params.distrib_type == 4)) {
+		LOG(INFO, "La escritura en flujo solo aplica al imprimir con -h, sin -sw, "
+				"-l morton ni 3d.");
+		params.stream = false;
+	}
 	
 	// Inicio control de tiempo total de multiplicación.
 	TIME_BEGIN(tiempo_total_multip);
 	
-	if (thread_count_read) {
-		LOG(INFO, "Multiplicación concurrente con %d hilo(s).", params.thread_count);
+	if (strassen != NULL) {
+		/*
+		 * Los productos de cada fase se reparten entre
+		 * los hilos del pool (si lo hay).
+		 */
+		LOG(INFO, "Multiplicación de Strassen-Winograd con %d hilo(s).", 
+				params.thread_count);
+		
+		TIME_BEGIN(tiempo_total_thr_exec);
+		strassen_mult(strassen, mat_a, mat_b, mat_c);
+		TIME_END(tiempo_total_thr_exec);
 		
+		if (pool != NULL)
+			despacho_pool = pool_last_stats(pool);
+	}
+	else if (zmat_c != NULL) {
 		/*
-		 * Multiplicación concurrentemente. La cantidad
-		 * de hilos se debe ajustar apropiadamente.
+		 * Multiplicación recursiva sobre la disposición
+		 * Morton, con los bloques de C repartidos entre
+		 * los hilos del pool (si lo hay).
 		 */
-		adjust_thread_count(&params);
+		LOG(INFO, "Multiplicación recursiva Morton con %d hilo(s).", params.thread_count);
+		
+		TIME_BEGIN(tiempo_total_thr_exec);
+		morton_mult(zmat_a, zmat_b, zmat_c, pool, params.thread_count);
+		TIME_END(tiempo_total_thr_exec);
 		
+		if (pool != NULL)
+			despacho_pool = pool_last_stats(pool);
+	}
+	else if (thread_count_read) {
+		LOG(INFO, "Multiplicación concurrente con %d hilo(s).", params.thread_count);
 		
 		/*
 		 * Realizar distribución de matrices
 		 */
-		LOG(INFO, "Realizando particionamiento de datos %dd.", params.distrib_type);
+		LOG(INFO, "Realizando particionamiento de datos %s.", distrib_name(params.distrib_type));
 		
 		// Inicio control de tiempo total de particionamiento.
 		TIME_BEGIN(tiempo_total_partit);
 		
-		matrix_mult_args *arguments = GET_MEM(matrix_mult_args, params.thread_count);
-		if (params.distrib_type == 1)
-			distrib_1d(mat_a, mat_b, mat_c, params.thread_count, arguments);
-		else if (params.distrib_type == 2)
-			distrib_2d(mat_a, mat_b, mat_c, params.thread_count, arguments);
-		else
-			LOG(FATAL, "Particionamiento distinto a 1d y 2d");
+		arguments = GET_MEM(matrix_mult_args, params.thread_count);
+		memset(arguments, 0, params.thread_count * sizeof(matrix_mult_args));
+		
+		distribute(params.distrib_type, mat_a, mat_b, mat_c, params.thread_count, 
+				arguments);
+		
+		for (i=0; i < params.thread_count; i++) {
+			arguments[i].qmatrix_a        = qmat_a;
+			arguments[i].qmatrix_b        = qmat_b;
+			arguments[i].counters_enabled = params.counters;
+		}
 		
 		// Fin control de tiempo total de particionamiento.
 		TIME_END(tiempo_total_partit);
 		
 		/*
-		 * Creación de hilos
+		 * Con escritura en flujo, el hilo escritor
+		 * comienza a imprimir A y B, y cada hilo le
+		 * informa las filas de C que termina.
+		 */
+		if (params.stream) {
+			LOG(INFO, "Imprimiendo matrices en flujo.");
+			TIME_BEGIN(tiempo_total_salida);
+			
+			if (stream_create(&stream, OUTPUT_FILE, mat_a, mat_b, mat_c, arguments, 
+					params.thread_count)) {
+				for (i=0; i < params.thread_count; i++)
+					arguments[i].stream = stream;
+			}
+			else {
+				LOG(WARN, "Error al abrir archivo de matrices \"%s\". %s", 
+						OUTPUT_FILE, "Se imprimirán al terminar.");
+				params.stream = false;
+			}
+		}
+		
+		/*
+		 * Despacho de los trabajos al pool. Con hilos
+		 * fijados, la partición i la procesa el hilo i,
+		 * que fue el que la inicializó.
 		 */
 		LOG(INFO, "Ejecutando hilos.");
 		
 		// Inicio control de tiempo total de ejecución de hilos.
 		TIME_BEGIN(tiempo_total_thr_exec);
 		
-		// Inicio control de tiempo total de creación de hilos.
-		TIME_BEGIN(tiempo_total_thr_creat);
-		
-		pthread_t *threads = GET_MEM(pthread_t, params.thread_count);
 		for (i=0; i < params.thread_count; i++) {
-			int rc = pthread_create(&threads[i], NULL, 
-								matrix_mult_thread, &arguments[i]);
-			
-			if (rc != 0)
-				LOG(FATAL, "Error en creación del hilo '%d'", i);
+			if (params.affinity)
+				pool_submit_to(pool, i, matrix_mult_thread, &arguments[i]);
+			else
+				pool_submit(pool, matrix_mult_thread, &arguments[i]);
 		}
 		
-		// Fin control de tiempo total de creación de hilos.
-		TIME_END(tiempo_total_thr_creat);
-		
 		/*
 		 * Esperar a los hilos.
 		 */
-		for (i=0; i < params.thread_count; i++) {
-			int rc = pthread_join(threads[i], NULL);
-			
-			if (rc != 0)
-				LOG(FATAL, "Error en 'join' del hilo '%d'", i);
-		}
+		pool_wait(pool);
+		
+		/*
+		 * Con particionamiento 3d, sumar las C parciales.
+		 */
+		reduce_partials(pool, arguments, params.thread_count);
 		
 		// Fin control de tiempo total de ejecución de hilos.
 		TIME_END(tiempo_total_thr_exec);
 		
+		despacho_pool = pool_last_stats(pool);
+		
+		if (params.distrib_auto)
+			LOG(INFO, "Modelo: tiempo predicho %.3f ms, medido %.3f ms (error %+.1f%%).",
+					NANOS_TO_MILLIS(plan.predicted), 
+					NANOS_TO_MILLIS(TIME_DIFF(tiempo_total_thr_exec)),
+					100.0 * (plan.predicted - TIME_DIFF(tiempo_total_thr_exec)) / 
+					MAX(TIME_DIFF(tiempo_total_thr_exec), 1));
+		
 		/*
 		 * Imprimimos las particiones de los hilos.
 		 */
 		print_partitions(arguments, params.thread_count);
-		
-		/*
-		 * Realizar limpieza
-		 */
-		LOG(INFO, "Liberando memoria de hilos.");		
-		free(threads);
-		free(arguments);
+		if (params.affinity)
+			print_placement(&topo, place, params.thread_count);
 	}
 	else {
 		/*
 		 * Multiplicación secuencial.
 		 */
 		LOG(INFO, "Multiplicación secuencial.");
-		matrix_mult(mat_a, mat_b, mat_c, 
-					0, matrix_rows(mat_c), 
-					0, matrix_cols(mat_c));
+		matrix_mult_sequential(mat_a, mat_b, qmat_a, qmat_b, mat_c);
 	}
 	
 	// Fin control de tiempo total de multiplicación.
 	TIME_END(tiempo_total_multip);
 	
+	/*
+	 * Esperamos al escritor, que imprime las últimas
+	 * filas de C.
+	 */
+	if (stream != NULL) {
+		if (!stream_finish(stream))
+			LOG(WARN, "Error al escribir el archivo de matrices \"%s\".", OUTPUT_FILE);
+		TIME_END(tiempo_total_salida);
+		
+		LOG(INFO, "Multiplicación e impresión en flujo: %.3f ms (multiplicación %.3f ms).",
+				NANOS_TO_MILLIS(TIME_DIFF(tiempo_total_salida)), 
+				NANOS_TO_MILLIS(TIME_DIFF(tiempo_total_thr_exec)));
+		LOG(INFO, "Escritor: %.3f ms imprimiendo, %.3f ms esperando filas de C.",
+				NANOS_TO_MILLIS(stream->write_nanos), NANOS_TO_MILLIS(stream->wait_nanos));
+		
+		stream_destroy(stream);
+	}
+	
+	if (zmat_c != NULL) {
+		LOG(INFO, "Convirtiendo matriz C a disposición por filas.");
+		matrix_from_morton(mat_c, zmat_c, pool, params.thread_count);
+	}
+	
+	/*
+	 * Si se solicitó, guardamos C en formato binario.
+	 */
+	if (params.file_c != NULL) {
+		LOG(INFO, "Guardando matriz C en \"%s\".", params.file_c);
+		matrix_file_write(mat_c, params.file_c);
+	}
+	
+	/*
+	 * La multiplicación secuencial es su propia
+	 * referencia, y se guarda para ejecuciones
+	 * concurrentes posteriores.
+	 */
+	if (!thread_count_read && strassen == NULL && zmat_c == NULL) {
+		tiempo_base = TIME_DIFF(tiempo_total_multip);
+		baseline_store(&base_key, tiempo_base);
+	}
+	
 	/*
 	 * Imprimimos los tiempos obtenidos.
 	 */
 	printf("\n");
 	print_times(tiempo_total_multip, 
 				tiempo_total_partit, 
-				tiempo_total_thr_creat, 
+				despacho_pool, 
 				tiempo_total_thr_exec,
+				tiempo_base,
+				params.quant_bits == 0 ? &roof : NULL,
+				arguments,
 				params.thread_count,
 				mat_a, mat_b, mat_c);
 	printf("\n");
 	
+	/*
+	 * Liberamos los argumentos de los hilos,
+	 * una vez impresos sus tiempos.
+	 */
+	if (arguments != NULL) {
+		LOG(INFO, "Liberando memoria de hilos.");
+		distrib_release(arguments, params.thread_count);
+		free(arguments);
+	}
+	
 	/*
 	 * Imprimir las matrices
 	 */
-	if (print_output) {
+	if (print_output && !params.stream) {
 		LOG(INFO, "Imprimiendo matrices.");
-		print_matrices(mat_a, mat_b, mat_c);
+		print_matrices(mat_a, mat_b, mat_c, pool, params.thread_count);
 	}
 	
 	
@@ -170,6 +597,24 @@ int main(int argc, char **argv) {
 	matrix_destroy(mat_a);
 	matrix_destroy(mat_b);
 	matrix_destroy(mat_c);
+	if (strassen != NULL)
+		strassen_destroy(strassen);
+	if (zmat_c != NULL) {
+		morton_destroy(zmat_a);
+		morton_destroy(zmat_b);
+		morton_destroy(zmat_c);
+	}
+	if (pool != NULL)
+		pool_destroy(pool);
+	if (qmat_a != NULL) {
+		qmatrix_destroy(qmat_a);
+		qmatrix_destroy(qmat_b);
+	}
+	if (place != NULL) {
+		free(place);
+		cpu_topology_free(&topo);
+	}
+	gemm_workspace_release();
 	
 	return EXIT_SUCCESS;
 }
@@ -1,7 +1,126 @@
 #include "matrix.h"
+#include "gemm.h"
 
-void matrix_create(matrix_t **mat, int nrows, int ncols) {
-    int i, j;
+#include <sys/mman.h>
+
+/*
+ * Tamaños de caché (en bytes) asumidos cuando
+ * no pueden leerse de sysfs.
+ */
+#define DEFAULT_L1_SIZE (32 * 1024)
+#define DEFAULT_L2_SIZE (256 * 1024)
+#define DEFAULT_L3_SIZE (8 * 1024 * 1024)
+
+/*
+ * Tamaños de bloque de la multiplicación.
+ */
+static matrix_tiles_t tiles = {256, 128, 4096};
+
+/*
+ * Páginas grandes para las matrices nuevas
+ * (ver matrix_hugepages_set()).
+ */
+static bool hugepages = false;
+
+/*
+ * Redondea "valor" hacia abajo a un múltiplo
+ * de "multiplo", sin bajar de "minimo".
+ */
+static int round_tile(long valor, int multiplo, int minimo) {
+	valor = valor / multiplo * multiplo;
+	return valor < minimo ? minimo : (valor > INT_MAX ? INT_MAX : (int) valor);
+}
+
+void matrix_tiles_init(int kc, int mc, int nc) {
+	cache_info_t cache;
+	long elem = sizeof(matrix_elem_t);
+	
+	if (!cache_info_read(&cache))
+		LOG(INFO, "No se pudieron leer los tamaños de caché, se asumen valores por defecto.");
+	
+	if (cache.l1 <= 0)
+		cache.l1 = DEFAULT_L1_SIZE;
+	if (cache.l2 <= 0)
+		cache.l2 = DEFAULT_L2_SIZE;
+	if (cache.l3 <= 0)
+		cache.l3 = DEFAULT_L3_SIZE;
+	
+	/*
+	 * Cada bloque ocupa a lo sumo la mitad de su
+	 * nivel de caché, dejando lugar para los demás
+	 * operandos (filas de A y C que pasan por él).
+	 */
+	tiles.kc = kc > 0 ? kc : round_tile(cache.l1 / 2 / (MATRIX_STRIP_COLS * elem), 8, 16);
+	tiles.mc = mc > 0 ? mc : round_tile(cache.l2 / 2 / (tiles.kc * elem), 8, 16);
+	tiles.nc = nc > 0 ? nc : round_tile(cache.l3 / 2 / (tiles.kc * elem), 
+										MATRIX_STRIP_COLS, MATRIX_STRIP_COLS);
+}
+
+matrix_tiles_t matrix_tiles_get(void) {
+	return tiles;
+}
+
+void matrix_hugepages_set(bool enabled) {
+	hugepages = enabled;
+}
+
+const char *matrix_storage_name(const matrix_t *mat) {
+	switch (mat->storage) {
+		case MATRIX_STORAGE_THP:     return "páginas grandes transparentes";
+		case MATRIX_STORAGE_HUGETLB: return "páginas grandes (hugetlbfs)";
+		case MATRIX_STORAGE_FILE:    return "archivo proyectado";
+		default:                     return "páginas comunes";
+	}
+}
+
+/*
+ * Asigna "size" bytes para los elementos de "mat"
+ * con páginas grandes: de hugetlbfs si hay páginas
+ * reservadas, o transparentes si no. Las páginas se
+ * asignan recién al escribirlas por primera vez.
+ */
+static void alloc_huge(matrix_t *mat, size_t size) {
+	size_t page = (size_t) huge_page_size();
+	void *ptr;
+	
+#ifdef MAP_HUGETLB
+	/*
+	 * La longitud de la proyección (y de su munmap)
+	 * debe ser múltiplo de la página de hugetlbfs.
+	 */
+	size_t tlb_page = (size_t) hugetlb_page_size();
+	size_t tlb_size = (size + tlb_page - 1) / tlb_page * tlb_page;
+	
+	ptr = mmap(NULL, tlb_size, PROT_READ | PROT_WRITE, 
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (ptr != MAP_FAILED) {
+		mat->elements = (matrix_elem_t *) ptr;
+		mat->storage  = MATRIX_STORAGE_HUGETLB;
+		mat->map_base = ptr;
+		mat->map_size = tlb_size;
+		return;
+	}
+#endif
+	
+	size = (size + page - 1) / page * page;
+	
+	/*
+	 * Sin páginas reservadas: bloque alineado a una
+	 * página grande, para que el núcleo pueda usarlas
+	 * desde el comienzo.
+	 */
+	mat->elements = (matrix_elem_t *) xmalloc_aligned(page, size);
+	mat->storage  = MATRIX_STORAGE_HEAP;
+	
+#ifdef MADV_HUGEPAGE
+	if (thp_available() && madvise(mat->elements, size, MADV_HUGEPAGE) == 0)
+		mat->storage = MATRIX_STORAGE_THP;
+#endif
+}
+
+void matrix_alloc(matrix_t **mat, int nrows, int ncols) {
+    int line_elems = CACHE_LINE_SIZE / sizeof(matrix_elem_t);
+    size_t size;
     
     // Chequeo de rangos
     if (nrows <= 0 || ncols <= 0)
@@ -10,44 +129,197 @@ void matrix_create(matrix_t **mat, int nrows, int ncols) {
     // Asignación de memoria para matrix_t
     (*mat) = GET_MEM(matrix_t, 1);
     
-    // Asignación de memoria para los elementos de la matriz
-    (*mat)->elements = GET_MEM(matrix_elem_t *, nrows);
-    for (i=0; i < nrows; i++)
-        (*mat)->elements[i] = GET_MEM(matrix_elem_t, ncols);
-    
-    // Establecer el número de filas y columnas
+    // Establecer el número de filas, columnas y la dimensión principal
     (*mat)->rows = nrows;
     (*mat)->cols = ncols;
+    (*mat)->ld   = (ncols + line_elems - 1) / line_elems * line_elems;
+    
+    // Asignación de un único bloque para todos los elementos
+    size = (size_t) nrows * (*mat)->ld;
+    (*mat)->storage  = MATRIX_STORAGE_HEAP;
+    (*mat)->map_base = NULL;
+    (*mat)->map_size = 0;
+    
+    if (hugepages && size * sizeof(matrix_elem_t) >= (size_t) huge_page_size())
+        alloc_huge(*mat, size * sizeof(matrix_elem_t));
+    else
+        (*mat)->elements = GET_MEM_ALIGNED(matrix_elem_t, size);
+}
+
+void matrix_create(matrix_t **mat, int nrows, int ncols) {
+    matrix_alloc(mat, nrows, ncols);
     
     // Inicialización de los elementos a cero
-    for (i=0; i < (*mat)->rows; i++)
-    for (j=0; j < (*mat)->cols; j++)
-        (*mat)->elements[i][j] = 0;
+    memset((*mat)->elements, 0, (size_t) nrows * (*mat)->ld * sizeof(matrix_elem_t));
 }
 
-void matrix_destroy(matrix_t *mat) {
-    int i;
+void matrix_view(matrix_t *view, matrix_t *base, int nrows, int ncols) {
+    int line_elems = CACHE_LINE_SIZE / sizeof(matrix_elem_t);
+    
+    view->rows     = nrows;
+    view->cols     = ncols;
+    view->ld       = (ncols + line_elems - 1) / line_elems * line_elems;
+    view->elements = base->elements;
     
-    // Liberar cada fila de la matriz
-    for (i=0; i < mat->rows; i++)
-        free(mat->elements[i]);
+    // La vista debe caber en el bloque de la matriz base
+    if (nrows <= 0 || ncols <= 0 || 
+            (size_t) nrows * view->ld > (size_t) base->rows * base->ld)
+        LOG(FATAL, "%s(): %s", __func__, "La vista no cabe en la matriz base.");
+}
+
+void matrix_block(matrix_t *view, matrix_t *base, int row, int col, int nrows, int ncols) {
     
-    // Liberar la matriz
-    free(mat->elements);
+    // El bloque debe caber en la matriz base
+    if (nrows <= 0 || ncols <= 0 || row < 0 || col < 0 || 
+            row + nrows > matrix_rows(base) || col + ncols > matrix_cols(base))
+        LOG(FATAL, "%s(): %s", __func__, "El bloque no cabe en la matriz base.");
+    
+    view->rows     = nrows;
+    view->cols     = ncols;
+    view->ld       = matrix_ld(base);
+    view->elements = matrix_row(base, row) + col;
+}
+
+void matrix_clear(matrix_t *mat, int row_begin, int row_count, 
+				 int col_begin, int col_count) {
+	int i;
+	
+	/*
+	 * El bloque que llega a la última columna
+	 * también limpia el relleno de cada fila.
+	 */
+	if (col_begin + col_count == matrix_cols(mat))
+		col_count = matrix_ld(mat) - col_begin;
+	
+	for (i=row_begin; i < row_begin + row_count; i++)
+		memset(matrix_row(mat, i) + col_begin, 0, col_count * sizeof(matrix_elem_t));
+}
+
+void matrix_destroy(matrix_t *mat) {
+    // Liberar el bloque de elementos
+    if (mat->storage == MATRIX_STORAGE_HUGETLB || mat->storage == MATRIX_STORAGE_FILE)
+        munmap(mat->map_base, mat->map_size);
+    else
+        free(mat->elements);
     
     // Liberar el objeto matrix_t
     free(mat);
 }
 
+/*
+ * Pares de dígitos decimales "00" a "99".
+ */
+static const char digit_pairs[] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+/*
+ * Escribe "valor" en decimal en "buf" con al menos
+ * "min_digits" dígitos (completando con ceros), y
+ * retorna la cantidad de caracteres.
+ */
+static int format_u64(char *buf, unsigned long long valor, int min_digits) {
+	char tmp[24];
+	int n = 0, len;
+	
+	while (valor >= 100) {
+		int par = (int) (valor % 100) * 2;
+		
+		valor /= 100;
+		tmp[n++] = digit_pairs[par + 1];
+		tmp[n++] = digit_pairs[par];
+	}
+	
+	if (valor >= 10) {
+		tmp[n++] = digit_pairs[valor * 2 + 1];
+		tmp[n++] = digit_pairs[valor * 2];
+	}
+	else
+		tmp[n++] = (char) ('0' + valor);
+	
+	while (n < min_digits)
+		tmp[n++] = '0';
+	
+	for (len=0; len < n; len++)
+		buf[len] = tmp[n - 1 - len];
+	
+	return n;
+}
+
+int matrix_format_elem(char *buf, matrix_elem_t valor) {
+#ifdef FLOAT
+	/*
+	 * valor = ±m·2^e, con m de 24 bits. Si e < 0,
+	 * valor·10^6 = m·10^6 / 2^-e se redondea (al par,
+	 * como printf()) con aritmética entera exacta; así
+	 * se obtienen la parte entera y los seis decimales.
+	 */
+	unsigned int bits;
+	unsigned long long m, escalado, resto, mitad;
+	int e, len = 0;
+	
+	memcpy(&bits, &valor, sizeof(bits));
+	e = (int) ((bits >> 23) & 0xff);
+	m = bits & 0x7fffff;
+	
+	if (e == 0xff)
+		return snprintf(buf, MATRIX_ELEM_MAX_CHARS, MATRIX_ELEM_T_FORMAT, valor);
+	
+	if (e == 0)
+		e = 1 - 150;		// Subnormal
+	else {
+		m |= 1u << 23;
+		e -= 150;
+	}
+	
+	// Magnitudes grandes o muy pequeñas: printf()
+	if (e > 20 || e < -63)
+		return snprintf(buf, MATRIX_ELEM_MAX_CHARS, MATRIX_ELEM_T_FORMAT, valor);
+	
+	if (e >= 0)
+		escalado = (m << e) * 1000000ULL;
+	else {
+		escalado = m * 1000000ULL;
+		resto    = escalado & ((1ULL << -e) - 1);
+		mitad    = 1ULL << (-e - 1);
+		escalado >>= -e;
+		
+		if (resto > mitad || (resto == mitad && (escalado & 1)))
+			escalado++;
+	}
+	
+	if (bits >> 31)
+		buf[len++] = '-';
+	len += format_u64(buf + len, escalado / 1000000, 1);
+	buf[len++] = '.';
+	len += format_u64(buf + len, escalado % 1000000, 6);
+	
+	return len;
+#else
+	// "%d": el valor se imprime como entero con signo
+	int entero = (int) valor;
+	
+	if (entero < 0) {
+		buf[0] = '-';
+		return 1 + format_u64(buf + 1, 0ULL - (long long) entero, 1);
+	}
+	
+	return format_u64(buf, (unsigned long long) entero, 1);
+#endif
+}
+
 void matrix_print(matrix_t *mat, FILE *destino) {
-    int i, j;
+    char buf[MATRIX_ELEM_MAX_CHARS + 1];
+    int i, j, len;
     
     for (i=0; i < matrix_rows(mat); i++) {
         for (j=0; j < matrix_cols(mat); j++) {
-            fprintf(destino, MATRIX_ELEM_T_FORMAT, matrix_val(mat, i, j));
-            fprintf(destino, "\t");
+            len = matrix_format_elem(buf, matrix_val(mat, i, j));
+            buf[len++] = '\t';
+            fwrite(buf, 1, len, destino);
         }
-        fprintf(destino, "\n");
+        fputc('\n', destino);
     }
 }
 
@@ -72,20 +344,86 @@ void matrix_fill(matrix_t *mat) {
         matrix_ref(mat, i, j) = (matrix_elem_t) (10.0 * (rand() / (RAND_MAX + 1.0)));
 }
 
+void matrix_fill_rows(matrix_t *mat, int row_begin, int row_count, unsigned int seed) {
+	unsigned int state;
+	int i, j;
+	
+	/*
+	 * Cada fila tiene su propia semilla, de modo que
+	 * el contenido no depende de qué hilo la carga.
+	 */
+	for (i=row_begin; i < row_begin + row_count; i++) {
+		state = seed ^ ((unsigned int) (i + 1) * 2654435761u);
+		
+		for (j=0; j < matrix_cols(mat); j++)
+			matrix_ref(mat, i, j) = (matrix_elem_t) (10.0 * (rand_r(&state) / (RAND_MAX + 1.0)));
+		
+		// El relleno de la fila queda en cero
+		for (; j < matrix_ld(mat); j++)
+			matrix_ref(mat, i, j) = 0;
+	}
+}
+
 void matrix_mult(matrix_t *a, matrix_t *b, matrix_t *c,
 				 int row_begin, int row_count, int col_begin, int col_count) {
 	
-	int i=0, j=0, k=0, k_end=0;
-	
 	if (matrix_cols(a) != matrix_rows(b))
 		LOG(FATAL, "%s(): %s %s", __func__, 
 				"El número de columnas de la matriz A debe ser igual a",
 				"el númbero de filas de la matriz B");
 	
-	k_end = matrix_cols(a) - 1;
+	gemm_mult(a, b, c, row_begin, row_count, col_begin, col_count);
+}
+
+void matrix_mult_blocked(matrix_t *a, matrix_t *b, matrix_t *c,
+				 int row_begin, int row_count, int col_begin, int col_count) {
+	
+	int i, j, k, ic, jc, jr, pc;
+	int mc, nc, kc, nr;
+	int row_end = row_begin + row_count;
+	int col_end = col_begin + col_count;
+	int k_end   = matrix_cols(a);
+	
+	if (matrix_cols(a) != matrix_rows(b))
+		LOG(FATAL, "%s(): %s %s", __func__, 
+				"El número de columnas de la matriz A debe ser igual a",
+				"el númbero de filas de la matriz B");
 	
-	for (i=row_begin; i < (row_begin + row_count); i++)
-	for (j=col_begin; j < (col_begin + col_count); j++)
-	for (k=0; k <= k_end; k++)
-		matrix_ref(c, i, j) += matrix_val(a, i, k) * matrix_val(b, k, j);
+	/*
+	 * Bloques de kc x nc de B (L3), recorridos
+	 * por bloques de mc x kc de A (L2).
+	 */
+	for (jc=col_begin; jc < col_end; jc += tiles.nc) {
+		nc = MIN(tiles.nc, col_end - jc);
+		
+		for (pc=0; pc < k_end; pc += tiles.kc) {
+			kc = MIN(tiles.kc, k_end - pc);
+			
+			for (ic=row_begin; ic < row_end; ic += tiles.mc) {
+				mc = MIN(tiles.mc, row_end - ic);
+				
+				/*
+				 * Cada franja de kc x nr de B (L1) se reutiliza
+				 * para las mc filas del bloque de A. El lazo
+				 * interno recorre filas de B y C en forma
+				 * contigua.
+				 */
+				for (jr=jc; jr < jc + nc; jr += MATRIX_STRIP_COLS) {
+					nr = MIN(MATRIX_STRIP_COLS, jc + nc - jr);
+					
+					for (i=ic; i < ic + mc; i++) {
+						matrix_elem_t *c_row = matrix_row(c, i) + jr;
+						
+						for (k=pc; k < pc + kc; k++) {
+							matrix_elem_t a_ik = matrix_val(a, i, k);
+							matrix_elem_t *b_row = matrix_row(b, k) + jr;
+							
+							for (j=0; j < nr; j++)
+								c_row[j] += a_ik * b_row[j];
+						}
+					}
+				}
+			}
+		}
+	}
 }
@@ -2,6 +2,8 @@
 #define MATRIX_H_
 
 #include "utils.h"
+#include "sysinfo.h"
+#include "counters.h"
 
 /*
  * Tipo de dato para los
@@ -10,35 +12,182 @@
 #ifdef FLOAT
     #define matrix_elem_t float
     #define MATRIX_ELEM_T_FORMAT "%f"
+    #define MATRIX_ELEM_T_NAME "float"
+    #define MATRIX_OPS_UNIT "GFLOPS"
 #else
     #define matrix_elem_t unsigned int
     #define MATRIX_ELEM_T_FORMAT "%d"
+    #define MATRIX_ELEM_T_NAME "uint32"
+    #define MATRIX_OPS_UNIT "GIOPS"
 #endif
 
+/*
+ * Origen del bloque de elementos de una matriz:
+ * memoria dinámica con páginas comunes o con
+ * páginas grandes transparentes (madvise), una
+ * proyección de páginas grandes de hugetlbfs o
+ * la proyección de un archivo (ver matrix_file.h).
+ */
+#define MATRIX_STORAGE_HEAP    0
+#define MATRIX_STORAGE_THP     1
+#define MATRIX_STORAGE_HUGETLB 2
+#define MATRIX_STORAGE_FILE    3
+
 /*
  * Tipo de dato matriz.
+ * 
+ * Los elementos se almacenan por filas en un único
+ * bloque contiguo alineado a una línea de caché. La
+ * fila "i" comienza en elements + i * ld, donde la
+ * dimensión principal "ld" es la cantidad de columnas
+ * redondeada a un múltiplo de una línea de caché, de
+ * modo que cada fila también queda alineada.
+ *
+ * "storage" indica el origen del bloque y, si es
+ * una proyección (mmap), "map_base" y "map_size" la
+ * región proyectada que lo contiene.
  */
 typedef struct {
-    matrix_elem_t **elements;
+    matrix_elem_t *elements;
     int rows;
     int cols;
+    int ld;
+    int storage;
+    void *map_base;
+    size_t map_size;
 } matrix_t;
 
+/*
+ * Matriz con elementos cuantizados (ver quant.h).
+ */
+typedef struct qmatrix qmatrix_t;
+
+/*
+ * Planificador de bloques con robo de
+ * trabajo (ver sched.h).
+ */
+typedef struct sched sched_t;
+
+/*
+ * Escritura en flujo del archivo de
+ * matrices (ver stream.h).
+ */
+typedef struct stream stream_t;
+
 /*
  * Tipo de dato para pasar los
  * argumentos a la función de
- * multiplicación.
+ * multiplicación. Si qmatrix_a y
+ * qmatrix_b no son nulos, se
+ * multiplican éstas en lugar de
+ * matrix_a y matrix_b. Si sched no
+ * es nulo, el hilo "thread_id" toma
+ * sus bloques del planificador en
+ * lugar de usar el rango indicado.
+ * En "times" el hilo registra sus
+ * tiempos de ejecución y, si
+ * counters_enabled es verdadero, en
+ * "counters" sus contadores de hardware.
+ * Con particionamiento 3d, el hilo
+ * multiplica solo el rango de la
+ * dimensión común [k_begin, k_begin +
+ * k_count), con matrix_a y matrix_b
+ * apuntando a slice_a y slice_b, y si
+ * k_group no es cero acumula en la C
+ * parcial partials[k_group] (que pone a
+ * cero al comenzar). Las partial_count
+ * matrices parciales (la primera es C)
+ * se suman luego con reduce_partials().
+ * Si stream no es nulo, el hilo le
+ * informa cada franja de filas de C
+ * que termina.
  */
 typedef struct {
 	matrix_t *matrix_a;
 	matrix_t *matrix_b;
 	matrix_t *matrix_c;
+	qmatrix_t *qmatrix_a;
+	qmatrix_t *qmatrix_b;
+	sched_t *sched;
+	stream_t *stream;
+	int thread_id;
 	int row_begin;
 	int row_count;
 	int col_begin;
 	int col_count;
+	int k_begin;
+	int k_count;
+	int k_group;
+	matrix_t slice_a;
+	matrix_t slice_b;
+	matrix_t **partials;
+	int partial_count;
+	thread_time_t times;
+	bool counters_enabled;
+	counters_t counters;
 } matrix_mult_args;
 
+/*
+ * Tamaños de bloque (en elementos) utilizados
+ * por la multiplicación. Cada uno apunta a un
+ * nivel de caché:
+ *   kc: profundidad de bloque (dimensión común). Una
+ *       franja de kc x MATRIX_STRIP_COLS de B (o un panel
+ *       empaquetado de B) cabe en L1.
+ *   mc: filas de un bloque de A de mc x kc, que cabe en L2.
+ *   nc: columnas de un bloque de B de kc x nc, que cabe en L3.
+ */
+typedef struct {
+	int kc;
+	int mc;
+	int nc;
+} matrix_tiles_t;
+
+/*
+ * Ancho (en elementos) de las franjas de columnas
+ * de B y C recorridas en el lazo más interno.
+ */
+#define MATRIX_STRIP_COLS 64
+
+/*
+ * Establece los tamaños de bloque de la
+ * multiplicación. Los valores no positivos
+ * se calculan a partir de los tamaños de
+ * caché leídos de sysfs.
+ */
+void matrix_tiles_init(int kc, int mc, int nc);
+
+/*
+ * Retorna los tamaños de bloque actuales.
+ */
+matrix_tiles_t matrix_tiles_get(void);
+
+/*
+ * Habilita (o deshabilita) las páginas grandes para
+ * las matrices que se creen a continuación: se usan
+ * las reservadas en hugetlbfs (MAP_HUGETLB) si las
+ * hay, si no páginas grandes transparentes, y si
+ * tampoco están disponibles, páginas comunes. Las
+ * matrices de menos de una página grande siempre
+ * usan páginas comunes.
+ */
+void matrix_hugepages_set(bool enabled);
+
+/*
+ * Retorna el nombre del origen del bloque de
+ * elementos de una matriz.
+ */
+const char *matrix_storage_name(const matrix_t *mat);
+
+/*
+ * Crea un objeto del tipo matrix_t con nrows
+ * filas y ncols columnas, sin inicializar los
+ * elementos. Las páginas del bloque se asignan
+ * recién al escribirlas por primera vez (en el
+ * nodo NUMA del hilo que lo hace).
+ */
+void matrix_alloc(matrix_t **mat, int nrows, int ncols);
+
 /*
  * Crea una objeto del tipo matrix_t con nrows
  * filas y ncols columnas, e inicializa todos
@@ -46,11 +195,47 @@ typedef struct {
  */
 void matrix_create(matrix_t **mat, int nrows, int ncols);
 
+/*
+ * Inicializa "view" como una matriz de nrows filas
+ * y ncols columnas que reutiliza el bloque de
+ * elementos de "base" (sin copiarlo), de modo de
+ * evitar nuevas asignaciones al recorrer tamaños
+ * menores. Los elementos no se inicializan. La
+ * vista no debe destruirse con matrix_destroy().
+ */
+void matrix_view(matrix_t *view, matrix_t *base, int nrows, int ncols);
+
+/*
+ * Inicializa "view" como el bloque de nrows x ncols
+ * de "base" que comienza en la fila "row" y la
+ * columna "col". Comparte los elementos y la
+ * dimensión principal de "base", por lo que las
+ * filas de la vista no incluyen relleno propio. La
+ * vista no debe destruirse con matrix_destroy().
+ */
+void matrix_block(matrix_t *view, matrix_t *base, int row, int col, int nrows, int ncols);
+
 /*
  * Destruye un objeto del tipo matrix_t.
  */
 void matrix_destroy(matrix_t *mat);
 
+/*
+ * Máxima cantidad de caracteres de un elemento
+ * escrito con matrix_format_elem() (un float con
+ * "%f" llega a 39 dígitos enteros).
+ */
+#define MATRIX_ELEM_MAX_CHARS 64
+
+/*
+ * Escribe en "buf" (sin terminador) el elemento
+ * "valor" exactamente como lo haría printf() con
+ * MATRIX_ELEM_T_FORMAT, y retorna la cantidad de
+ * caracteres. Los enteros y los reales de magnitud
+ * moderada se convierten sin printf().
+ */
+int matrix_format_elem(char *buf, matrix_elem_t valor);
+
 /*
  * Imprime un objeto del tipo matrix_t en
  * el archivo "destino".
@@ -63,35 +248,76 @@ void matrix_print(matrix_t *mat, FILE *destino);
 void matrix_fill(matrix_t *mat);
 
 /*
- * Multiplica dos matrices.
+ * Carga las filas [row_begin, row_begin + row_count)
+ * de una matriz con valores aleatorios a partir de
+ * "seed". El resultado no depende de cómo se repartan
+ * las filas entre hilos.
+ */
+void matrix_fill_rows(matrix_t *mat, int row_begin, int row_count, unsigned int seed);
+
+/*
+ * Pone a cero el bloque de filas [row_begin,
+ * row_begin + row_count) y columnas [col_begin,
+ * col_begin + col_count) de una matriz.
+ */
+void matrix_clear(matrix_t *mat, int row_begin, int row_count, 
+				 int col_begin, int col_count);
+
+/*
+ * Multiplica dos matrices, acumulando en C el
+ * bloque de filas [row_begin, row_begin + row_count)
+ * y columnas [col_begin, col_begin + col_count) del
+ * producto A x B. Utiliza paneles empaquetados y el
+ * micro-núcleo seleccionado con gemm_init(), con los
+ * tamaños de bloque establecidos con matrix_tiles_init().
  */
 void matrix_mult(matrix_t *a, matrix_t *b, matrix_t *c,
 				 int row_begin, int row_count, int col_begin, int col_count);
 
+/*
+ * Variante de matrix_mult() por bloques, sin
+ * empaquetado: recorre A, B y C directamente.
+ */
+void matrix_mult_blocked(matrix_t *a, matrix_t *b, matrix_t *c,
+				 int row_begin, int row_count, int col_begin, int col_count);
+
 /*
  * Obtiene el numero de filas de un objeto 
  * del tipo matrix_t.
  */
-#define matrix_rows(mat) mat->rows
+#define matrix_rows(mat) (mat)->rows
 
 /* 
  * Obtiene el numero de columnas de un objeto 
  * del tipo matrix_t.
  */
-#define matrix_cols(mat) mat->cols
+#define matrix_cols(mat) (mat)->cols
+
+/*
+ * Obtiene la dimensión principal (distancia
+ * en elementos entre dos filas consecutivas)
+ * de un objeto del tipo matrix_t.
+ */
+#define matrix_ld(mat) (mat)->ld
+
+/*
+ * Obtiene un puntero al primer elemento de
+ * la fila "row" de un objeto del tipo matrix_t.
+ */
+#define matrix_row(mat, row) ((mat)->elements + (size_t) (row) * (mat)->ld)
 
 /*
  * Obtiene el valor del elemento en la 
  * posición (row, col) de un objeto del 
  * tipo matrix_t.
  */
-#define matrix_val(mat, row, col) (mat->elements[row][col])
+#define matrix_val(mat, row, col) (matrix_row(mat, row)[col])
 
 /*
  * Obtiene la referencia del elemento en la 
  * posición (row, col) de un objeto del 
  * tipo matrix_t.
  */
-#define matrix_ref(mat, row, col) (*(mat->elements[row] + col))
+#define matrix_ref(mat, row, col) (*(matrix_row(mat, row) + (col)))
 
 #endif /*MATRIX_H_*/
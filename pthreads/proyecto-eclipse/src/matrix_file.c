@@ -0,0 +1,797 @@
+#include "matrix_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+_Static_assert(sizeof(matrix_file_header_t) == MATRIX_FILE_HEADER_SIZE,
+		"La cabecera del archivo de matrices debe ocupar MATRIX_FILE_HEADER_SIZE bytes");
+
+/*
+ * Lee la cabecera de un archivo abierto y verifica
+ * que describa una matriz de matrix_elem_t cuyos
+ * datos estén completos en el archivo.
+ */
+static bool read_header(int fd, const char *path, matrix_file_header_t *header) {
+	struct stat info;
+	const char *motivo = NULL;
+	
+	if (fstat(fd, &info) != 0 || 
+			pread(fd, header, sizeof(*header), 0) != (ssize_t) sizeof(*header))
+		motivo = "no se pudo leer la cabecera";
+	else if (memcmp(header->magic, MATRIX_FILE_MAGIC, sizeof(header->magic)) != 0)
+		motivo = "no es un archivo de matrices";
+	else if (header->byte_order != MATRIX_FILE_BYTE_ORDER)
+		motivo = "fue escrito con otro orden de bytes";
+	else if (header->version != MATRIX_FILE_VERSION)
+		motivo = "versión de formato no soportada";
+	else if (header->elem_type != MATRIX_FILE_ELEM_TYPE || 
+			header->elem_size != sizeof(matrix_elem_t))
+		motivo = "el tipo de elementos no es " MATRIX_ELEM_T_NAME;
+	else if (header->rows == 0 || header->cols == 0 || header->rows > INT_MAX ||
+			header->ld > INT_MAX || header->ld < header->cols)
+		motivo = "dimensiones inválidas";
+	else if (header->data_offset < MATRIX_FILE_HEADER_SIZE || 
+			header->data_offset % CACHE_LINE_SIZE != 0)
+		motivo = "desplazamiento de los datos inválido";
+	else if ((uint64_t) info.st_size < header->data_offset + 
+			(uint64_t) header->rows * header->ld * sizeof(matrix_elem_t))
+		motivo = "el archivo está incompleto";
+	
+	if (motivo != NULL) {
+		LOG(WARN, "Archivo de matrices \"%s\": %s.", path, motivo);
+		return false;
+	}
+	
+	return true;
+}
+
+void matrix_file_map(matrix_t **mat, const char *path) {
+	matrix_file_header_t header;
+	size_t size;
+	void *base;
+	int fd;
+	
+	if ((fd = open(path, O_RDONLY)) < 0)
+		LOG(FATAL, "No se pudo abrir el archivo de matrices \"%s\". %s", path, 
+				strerror(errno));
+	
+	if (!read_header(fd, path, &header))
+		LOG(FATAL, "%s(): %s", __func__, "Archivo de matrices inválido.");
+	
+	/*
+	 * Proyección privada: la matriz puede escribirse
+	 * (copia al escribir) sin modificar el archivo.
+	 */
+	size = header.data_offset + (size_t) header.rows * header.ld * sizeof(matrix_elem_t);
+	base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	
+	if (base == MAP_FAILED)
+		LOG(FATAL, "No se pudo proyectar el archivo de matrices \"%s\". %s", path, 
+				strerror(errno));
+	
+	// Lectura anticipada, sin esperarla
+	madvise(base, size, MADV_WILLNEED);
+	
+	(*mat) = GET_MEM(matrix_t, 1);
+	(*mat)->rows     = (int) header.rows;
+	(*mat)->cols     = (int) header.cols;
+	(*mat)->ld       = (int) header.ld;
+	(*mat)->elements = (matrix_elem_t *) ((char *) base + header.data_offset);
+	(*mat)->storage  = MATRIX_STORAGE_FILE;
+	(*mat)->map_base = base;
+	(*mat)->map_size = size;
+}
+
+/*
+ * Completa la cabecera de una matriz de rows x cols
+ * con dimensión principal "ld".
+ */
+static void header_init(matrix_file_header_t *header, int rows, int cols, int ld) {
+	memset(header, 0, sizeof(*header));
+	memcpy(header->magic, MATRIX_FILE_MAGIC, sizeof(header->magic));
+	header->version     = MATRIX_FILE_VERSION;
+	header->byte_order  = MATRIX_FILE_BYTE_ORDER;
+	header->elem_type   = MATRIX_FILE_ELEM_TYPE;
+	header->elem_size   = sizeof(matrix_elem_t);
+	header->rows        = rows;
+	header->cols        = cols;
+	header->ld          = ld;
+	header->data_offset = MATRIX_FILE_HEADER_SIZE;
+}
+
+void matrix_file_write(matrix_t *mat, const char *path) {
+	matrix_file_header_t header;
+	matrix_elem_t *relleno;
+	FILE *archivo = NULL;
+	int i, pad = matrix_ld(mat) - matrix_cols(mat);
+	bool ok = true;
+	
+	header_init(&header, matrix_rows(mat), matrix_cols(mat), matrix_ld(mat));
+	
+	if ((archivo = fopen(path, "wb")) == NULL)
+		LOG(FATAL, "No se pudo crear el archivo de matrices \"%s\". %s", path, 
+				strerror(errno));
+	
+	relleno = GET_MEM(matrix_elem_t, MAX(pad, 1));
+	memset(relleno, 0, MAX(pad, 1) * sizeof(matrix_elem_t));
+	ok = fwrite(&header, sizeof(header), 1, archivo) == 1;
+	
+	for (i=0; ok && i < matrix_rows(mat); i++) {
+		ok = fwrite(matrix_row(mat, i), sizeof(matrix_elem_t), matrix_cols(mat), 
+				archivo) == (size_t) matrix_cols(mat);
+		
+		if (ok && pad > 0)
+			ok = fwrite(relleno, sizeof(matrix_elem_t), pad, archivo) == (size_t) pad;
+	}
+	
+	free(relleno);
+	if (fclose(archivo) != 0 || !ok)
+		LOG(FATAL, "Error al escribir el archivo de matrices \"%s\".", path);
+}
+
+int matrix_file_open(const char *path, matrix_file_header_t *header) {
+	int fd;
+	
+	if ((fd = open(path, O_RDONLY)) < 0)
+		LOG(FATAL, "No se pudo abrir el archivo de matrices \"%s\". %s", path, 
+				strerror(errno));
+	
+	if (!read_header(fd, path, header))
+		LOG(FATAL, "%s(): %s", __func__, "Archivo de matrices binario inválido.");
+	
+	return fd;
+}
+
+int matrix_file_create(const char *path, int rows, int cols, matrix_file_header_t *header) {
+	int line_elems = CACHE_LINE_SIZE / sizeof(matrix_elem_t);
+	off_t size;
+	int fd;
+	
+	header_init(header, rows, cols, (cols + line_elems - 1) / line_elems * line_elems);
+	size = header->data_offset + (off_t) header->rows * header->ld * sizeof(matrix_elem_t);
+	
+	if ((fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0)
+		LOG(FATAL, "No se pudo crear el archivo de matrices \"%s\". %s", path, 
+				strerror(errno));
+	
+	// Los datos aún no escritos se leen como ceros
+	if (!matrix_file_pwrite(fd, header, sizeof(*header), 0) || ftruncate(fd, size) != 0)
+		LOG(FATAL, "Error al escribir el archivo de matrices \"%s\".", path);
+	
+	return fd;
+}
+
+/*
+ * Desplazamiento en el archivo del elemento
+ * (row, col).
+ */
+static off_t elem_offset(const matrix_file_header_t *header, int row, int col) {
+	return header->data_offset + 
+			((off_t) row * header->ld + col) * (off_t) sizeof(matrix_elem_t);
+}
+
+bool matrix_file_read_block(int fd, const matrix_file_header_t *header, int row, 
+		int col, matrix_t *block) {
+	
+	size_t count = matrix_cols(block) * sizeof(matrix_elem_t);
+	char *p;
+	off_t offset;
+	ssize_t leidos;
+	size_t resto;
+	int i;
+	
+	if (row < 0 || col < 0 || row + matrix_rows(block) > (int) header->rows ||
+			col + matrix_cols(block) > (int) header->cols)
+		return false;
+	
+	for (i=0; i < matrix_rows(block); i++) {
+		p      = (char *) matrix_row(block, i);
+		offset = elem_offset(header, row + i, col);
+		resto  = count;
+		
+		while (resto > 0) {
+			leidos = pread(fd, p, resto, offset);
+			if (leidos < 0 && errno == EINTR)
+				continue;
+			if (leidos <= 0)
+				return false;
+			
+			p      += leidos;
+			resto  -= leidos;
+			offset += leidos;
+		}
+	}
+	
+	return true;
+}
+
+bool matrix_file_write_block(int fd, const matrix_file_header_t *header, int row, 
+		int col, matrix_t *block) {
+	
+	int i;
+	
+	if (row < 0 || col < 0 || row + matrix_rows(block) > (int) header->rows ||
+			col + matrix_cols(block) > (int) header->cols)
+		return false;
+	
+	for (i=0; i < matrix_rows(block); i++)
+		if (!matrix_file_pwrite(fd, matrix_row(block, i), 
+				matrix_cols(block) * sizeof(matrix_elem_t), elem_offset(header, row + i, col)))
+			return false;
+	
+	return true;
+}
+
+/*
+ * Archivo de texto proyectado en memoria ("mapped"
+ * bytes), sin los blancos finales ("size" bytes
+ * útiles). La fila i ocupa los bytes
+ * [row_start[i], row_start[i + 1] - 1) (sin el salto
+ * de línea).
+ */
+typedef struct {
+	const char *path;
+	const char *text;
+	size_t mapped;
+	size_t size;
+	size_t *row_start;
+	int rows;
+	int cols;
+	matrix_t *mat;
+} text_file_t;
+
+/*
+ * Trabajo de la lectura de texto: trozo de bytes
+ * [begin, end) en el que se cuentan (y luego se
+ * ubican) los saltos de línea, a partir de la fila
+ * first_row, o franja de filas [row_begin, row_end)
+ * que se convierte.
+ */
+typedef struct {
+	text_file_t *file;
+	size_t begin, end;
+	long lines;
+	long first_row;
+	int row_begin, row_end;
+} text_job_t;
+
+/*
+ * Ejecuta "count" trabajos en el pool o, si es
+ * nulo, en el hilo que la invoca.
+ */
+static void run_jobs(pool_t *pool, text_job_t *jobs, int count, pool_fn fn) {
+	int i;
+	
+	for (i=0; i < count; i++) {
+		if (pool != NULL)
+			pool_submit(pool, fn, &jobs[i]);
+		else
+			fn(&jobs[i]);
+	}
+	
+	if (pool != NULL)
+		pool_wait(pool);
+}
+
+static bool is_blank(char c) {
+	return c == '\n' || c == '\r' || c == '\t' || c == ' ';
+}
+
+/*
+ * Proyecta el archivo de texto y descarta los
+ * blancos finales.
+ */
+static bool text_open(text_file_t *file, const char *path) {
+	struct stat info;
+	void *base;
+	int fd;
+	
+	memset(file, 0, sizeof(*file));
+	file->path = path;
+	
+	if ((fd = open(path, O_RDONLY)) < 0 || fstat(fd, &info) != 0) {
+		LOG(WARN, "No se pudo abrir el archivo de matrices \"%s\". %s", path, 
+				strerror(errno));
+		if (fd >= 0)
+			close(fd);
+		return false;
+	}
+	
+	if (info.st_size == 0) {
+		LOG(WARN, "Archivo de matrices \"%s\": %s.", path, "está vacío");
+		close(fd);
+		return false;
+	}
+	
+	base = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	
+	if (base == MAP_FAILED) {
+		LOG(WARN, "No se pudo proyectar el archivo de matrices \"%s\". %s", path, 
+				strerror(errno));
+		return false;
+	}
+	
+	madvise(base, info.st_size, MADV_SEQUENTIAL);
+	file->text   = (const char *) base;
+	file->mapped = info.st_size;
+	file->size   = info.st_size;
+	
+	while (file->size > 0 && is_blank(file->text[file->size - 1]))
+		file->size--;
+	
+	return true;
+}
+
+static void text_close(text_file_t *file) {
+	munmap((void *) file->text, file->mapped);
+	free(file->row_start);
+}
+
+/*
+ * Cantidad de elementos de la primera línea: cada
+ * uno termina en un tabulador (el último puede no
+ * tenerlo si es la última línea).
+ */
+static int first_line_cols(const text_file_t *file) {
+	const char *fin = memchr(file->text, '\n', file->size);
+	size_t len = fin != NULL ? (size_t) (fin - file->text) : file->size;
+	int cols = 0;
+	size_t i;
+	
+	while (len > 0 && (file->text[len - 1] == '\r' || file->text[len - 1] == ' '))
+		len--;
+	
+	for (i=0; i < len; i++)
+		if (file->text[i] == '\t')
+			cols++;
+	
+	if (len > 0 && file->text[len - 1] != '\t')
+		cols++;
+	
+	return cols;
+}
+
+/*
+ * Primera pasada: saltos de línea del trozo.
+ */
+static void count_lines(void *args) {
+	text_job_t *aux = (text_job_t *) args;
+	const char *p = aux->file->text + aux->begin;
+	const char *fin = aux->file->text + aux->end;
+	
+	aux->lines = 0;
+	while ((p = memchr(p, '\n', fin - p)) != NULL) {
+		aux->lines++;
+		p++;
+	}
+}
+
+/*
+ * Segunda pasada: comienzo de las filas que siguen
+ * a cada salto de línea del trozo.
+ */
+static void find_rows(void *args) {
+	text_job_t *aux = (text_job_t *) args;
+	const char *p = aux->file->text + aux->begin;
+	const char *fin = aux->file->text + aux->end;
+	long fila = aux->first_row;
+	
+	while ((p = memchr(p, '\n', fin - p)) != NULL) {
+		p++;
+		aux->file->row_start[++fila] = p - aux->file->text;
+	}
+}
+
+/*
+ * Convierte el elemento que comienza en "p" (sin
+ * pasar de "fin"): [-]dígitos para enteros (como los
+ * escribe "%d", incluso si son negativos) y
+ * [-]dígitos[.dígitos] para reales. Las demás formas
+ * de reales (exponentes, inf, nan) se convierten con
+ * strtod(). Retorna la posición siguiente al
+ * elemento, o NULL si no hay uno válido.
+ */
+static const char *parse_elem(const char *p, const char *fin, matrix_elem_t *valor) {
+#ifdef FLOAT
+	const char *token = p;	// Para strtod()
+#endif
+	unsigned long long entero = 0;
+	bool negativo = false;
+	int digitos = 0;
+	
+	if (p < fin && (*p == '-' || *p == '+'))
+		negativo = *p++ == '-';
+	
+	while (p < fin && *p >= '0' && *p <= '9') {
+		entero = entero * 10 + (*p++ - '0');
+		digitos++;
+	}
+	
+#ifdef FLOAT
+	{
+		static const double potencias[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+				1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+		unsigned long long fraccion = 0;
+		int decimales = 0;
+		double resultado;
+		
+		if (p < fin && *p == '.') {
+			p++;
+			while (p < fin && *p >= '0' && *p <= '9' && decimales < 18) {
+				fraccion = fraccion * 10 + (*p++ - '0');
+				decimales++;
+			}
+		}
+		
+		/*
+		 * Formas poco comunes (o con demasiados
+		 * dígitos): conversión de la biblioteca.
+		 */
+		if ((digitos == 0 && decimales == 0) || digitos > 18 || 
+				(p < fin && *p != '\t' && *p != '\r' && *p != ' ')) {
+			char buf[64], *resto;
+			int len;
+			
+			for (len=0; token + len < fin && len < (int) sizeof(buf) - 1 && 
+					!is_blank(token[len]); len++)
+				buf[len] = token[len];
+			buf[len] = '\0';
+			
+			resultado = strtod(buf, &resto);
+			if (resto == buf)
+				return NULL;
+			
+			*valor = (matrix_elem_t) resultado;
+			return token + (resto - buf);
+		}
+		
+		/*
+		 * Si entero·10^decimales + fracción es exacto en
+		 * un double, basta una división (correctamente
+		 * redondeada).
+		 */
+		if (entero < (1ULL << 53) / (unsigned long long) potencias[decimales] && 
+				decimales <= 15)
+			resultado = DOUBLE(entero * (unsigned long long) potencias[decimales] + 
+					fraccion) / potencias[decimales];
+		else
+			resultado = DOUBLE(entero) + DOUBLE(fraccion) / potencias[decimales];
+		
+		*valor = (matrix_elem_t) (negativo ? -resultado : resultado);
+	}
+#else
+	if (digitos == 0)
+		return NULL;
+	
+	*valor = (matrix_elem_t) (negativo ? 0ULL - entero : entero);
+#endif
+	
+	return p;
+}
+
+/*
+ * Tercera pasada: convierte la franja de filas.
+ */
+static void parse_rows(void *args) {
+	text_job_t *aux = (text_job_t *) args;
+	text_file_t *file = aux->file;
+	const char *p, *fin;
+	matrix_elem_t *fila;
+	int i, j;
+	
+	for (i=aux->row_begin; i < aux->row_end; i++) {
+		p    = file->text + file->row_start[i];
+		fin  = file->text + file->row_start[i + 1] - 1;
+		fila = matrix_row(file->mat, i);
+		
+		for (j=0; j < file->cols; j++) {
+			while (p < fin && *p == ' ')
+				p++;
+			
+			if ((p = parse_elem(p, fin, &fila[j])) == NULL)
+				break;
+			
+			// Separador (el del último elemento es opcional)
+			if (p < fin && *p == '\t')
+				p++;
+			else if (j < file->cols - 1)
+				break;
+		}
+		
+		while (p != NULL && p < fin && (*p == '\r' || *p == ' '))
+			p++;
+		
+		if (j < file->cols || p != fin)
+			LOG(FATAL, "Archivo de matrices \"%s\": la fila %d no tiene %d elementos.",
+					file->path, i + 1, file->cols);
+	}
+}
+
+/*
+ * Lee un archivo de texto: busca los comienzos de
+ * fila en trozos del archivo (contando primero los
+ * saltos de línea de cada uno, para saber en qué
+ * fila comienza) y luego convierte franjas de filas,
+ * todo repartido en el pool.
+ */
+static void text_load(matrix_t **mat, const char *path, pool_t *pool, int thread_count) {
+	text_file_t file;
+	text_job_t *jobs;
+	long filas;
+	int i, count;
+	
+	if (!text_open(&file, path))
+		LOG(FATAL, "%s(): %s", __func__, "Archivo de matrices inválido.");
+	
+	/*
+	 * Trozos de al menos una página, y una franja de
+	 * filas por hilo para la conversión.
+	 */
+	count = pool != NULL ? MAX(thread_count, 1) * MATRIX_TEXT_CHUNKS_PER_THREAD : 1;
+	count = (int) MIN((size_t) count, MAX(file.size / 4096, 1));
+	jobs  = GET_MEM(text_job_t, MAX(count, MAX(thread_count, 1)));
+	
+	for (i=0; i < count; i++) {
+		jobs[i].file  = &file;
+		jobs[i].begin = file.size * i / count;
+		jobs[i].end   = file.size * (i + 1) / count;
+	}
+	run_jobs(pool, jobs, count, count_lines);
+	
+	// Fila en la que comienza cada trozo
+	for (i=0, filas=0; i < count; i++) {
+		jobs[i].first_row = filas;
+		filas += jobs[i].lines;
+	}
+	
+	if (filas + 1 > INT_MAX)
+		LOG(FATAL, "Archivo de matrices \"%s\": %s.", path, "demasiadas filas");
+	
+	file.rows = (int) filas + 1;
+	file.cols = first_line_cols(&file);
+	if (file.cols == 0)
+		LOG(FATAL, "Archivo de matrices \"%s\": %s.", path, "la primera fila está vacía");
+	
+	file.row_start = GET_MEM(size_t, (file.rows + 1));
+	file.row_start[0]         = 0;
+	file.row_start[file.rows] = file.size + 1;
+	run_jobs(pool, jobs, count, find_rows);
+	
+	/*
+	 * La matriz se escribe por primera vez en los
+	 * hilos que convierten cada franja.
+	 */
+	matrix_alloc(&file.mat, file.rows, file.cols);
+	
+	count = pool != NULL ? MIN(MAX(thread_count, 1), file.rows) : 1;
+	for (i=0; i < count; i++) {
+		jobs[i].file      = &file;
+		jobs[i].row_begin = (int) ((long) file.rows * i / count);
+		jobs[i].row_end   = (int) ((long) file.rows * (i + 1) / count);
+	}
+	run_jobs(pool, jobs, count, parse_rows);
+	
+	*mat = file.mat;
+	free(jobs);
+	text_close(&file);
+}
+
+/*
+ * Retorna true si el archivo comienza con
+ * MATRIX_FILE_MAGIC (formato binario).
+ */
+static bool is_binary(const char *path) {
+	char magic[sizeof(MATRIX_FILE_MAGIC) - 1];
+	bool binario = false;
+	int fd;
+	
+	if ((fd = open(path, O_RDONLY)) >= 0) {
+		binario = read(fd, magic, sizeof(magic)) == (ssize_t) sizeof(magic) &&
+				memcmp(magic, MATRIX_FILE_MAGIC, sizeof(magic)) == 0;
+		close(fd);
+	}
+	
+	return binario;
+}
+
+void matrix_file_load(matrix_t **mat, const char *path, pool_t *pool, int thread_count) {
+	if (is_binary(path))
+		matrix_file_map(mat, path);
+	else
+		text_load(mat, path, pool, thread_count);
+}
+
+/*
+ * Dimensiones de un archivo de texto: cantidad de
+ * líneas y de elementos de la primera.
+ */
+static bool text_info(const char *path, int *rows, int *cols) {
+	text_file_t file;
+	const char *p, *fin;
+	long filas = 1;
+	
+	if (!text_open(&file, path))
+		return false;
+	
+	p   = file.text;
+	fin = file.text + file.size;
+	while ((p = memchr(p, '\n', fin - p)) != NULL) {
+		filas++;
+		p++;
+	}
+	
+	*rows = (int) MIN(filas, INT_MAX);
+	*cols = first_line_cols(&file);
+	text_close(&file);
+	
+	if (*cols == 0 || filas > INT_MAX) {
+		LOG(WARN, "Archivo de matrices \"%s\": %s.", path, "dimensiones inválidas");
+		return false;
+	}
+	
+	return true;
+}
+
+bool matrix_file_info(const char *path, int *rows, int *cols) {
+	matrix_file_header_t header;
+	bool valido;
+	int fd;
+	
+	if (!is_binary(path))
+		return text_info(path, rows, cols);
+	
+	if ((fd = open(path, O_RDONLY)) < 0) {
+		LOG(WARN, "No se pudo abrir el archivo de matrices \"%s\". %s", path, 
+				strerror(errno));
+		return false;
+	}
+	
+	valido = read_header(fd, path, &header);
+	close(fd);
+	
+	if (valido) {
+		*rows = (int) header.rows;
+		*cols = (int) header.cols;
+	}
+	
+	return valido;
+}
+
+bool matrix_file_pwrite(int fd, const void *buf, size_t count, off_t offset) {
+	const char *p = (const char *) buf;
+	ssize_t escritos;
+	
+	while (count > 0) {
+		escritos = pwrite(fd, p, count, offset);
+		if (escritos < 0 && errno == EINTR)
+			continue;
+		if (escritos <= 0)
+			return false;
+		
+		p      += escritos;
+		count  -= escritos;
+		offset += escritos;
+	}
+	
+	return true;
+}
+
+/*
+ * Trabajo de la escritura de texto: franja de filas
+ * [row_begin, row_end), su texto y su posición en el
+ * archivo.
+ */
+typedef struct {
+	matrix_t *mat;
+	int fd;
+	int row_begin, row_end;
+	char *text;
+	size_t size;
+	off_t offset;
+	bool ok;
+} print_job_t;
+
+/*
+ * Convierte la franja de filas a texto. El buffer
+ * se agranda si algún elemento es más largo que lo
+ * estimado.
+ */
+static void format_rows(void *args) {
+	print_job_t *aux = (print_job_t *) args;
+	matrix_t *mat = aux->mat;
+	size_t capacidad, usados = 0;
+	matrix_elem_t *fila;
+	int i, j;
+	
+	// Estimación: hasta 11 caracteres y un tabulador por elemento
+	capacidad = (size_t) (aux->row_end - aux->row_begin) * (matrix_cols(mat) * 12 + 1) +
+			MATRIX_ELEM_MAX_CHARS + 2;
+	aux->text = GET_MEM(char, capacidad);
+	
+	for (i=aux->row_begin; i < aux->row_end; i++) {
+		fila = matrix_row(mat, i);
+		
+		for (j=0; j < matrix_cols(mat); j++) {
+			if (capacidad - usados < MATRIX_ELEM_MAX_CHARS + 2) {
+				capacidad *= 2;
+				if ((aux->text = (char *) realloc(aux->text, capacidad)) == NULL)
+					LOG(FATAL, "%s(): %s", __func__, "Memoria no disponible.");
+			}
+			
+			usados += matrix_format_elem(aux->text + usados, fila[j]);
+			aux->text[usados++] = '\t';
+		}
+		aux->text[usados++] = '\n';
+	}
+	
+	aux->size = usados;
+}
+
+static void write_rows(void *args) {
+	print_job_t *aux = (print_job_t *) args;
+	
+	aux->ok = matrix_file_pwrite(aux->fd, aux->text, aux->size, aux->offset);
+	free(aux->text);
+}
+
+off_t matrix_file_print(matrix_t *mat, int fd, off_t offset, pool_t *pool,
+		int thread_count) {
+	
+	return matrix_file_print_rows(mat, 0, matrix_rows(mat), fd, offset, pool, thread_count);
+}
+
+off_t matrix_file_print_rows(matrix_t *mat, int row_begin, int row_end, int fd,
+		off_t offset, pool_t *pool, int thread_count) {
+	
+	print_job_t *jobs;
+	bool ok = true;
+	int i, count, rows = row_end - row_begin;
+	
+	if (rows <= 0)
+		return offset;
+	
+	count = pool != NULL ? MAX(thread_count, 1) * MATRIX_PRINT_BANDS_PER_THREAD : 1;
+	count = MIN(count, rows);
+	jobs  = GET_MEM(print_job_t, count);
+	
+	for (i=0; i < count; i++) {
+		jobs[i].mat       = mat;
+		jobs[i].fd        = fd;
+		jobs[i].row_begin = row_begin + (int) ((long) rows * i / count);
+		jobs[i].row_end   = row_begin + (int) ((long) rows * (i + 1) / count);
+		
+		if (pool != NULL)
+			pool_submit(pool, format_rows, &jobs[i]);
+		else
+			format_rows(&jobs[i]);
+	}
+	if (pool != NULL)
+		pool_wait(pool);
+	
+	// Posición de cada franja en el archivo
+	for (i=0; i < count; i++) {
+		jobs[i].offset = offset;
+		offset += jobs[i].size;
+	}
+	
+	for (i=0; i < count; i++) {
+		if (pool != NULL)
+			pool_submit(pool, write_rows, &jobs[i]);
+		else
+			write_rows(&jobs[i]);
+	}
+	if (pool != NULL)
+		pool_wait(pool);
+	
+	for (i=0; i < count; i++)
+		ok = ok && jobs[i].ok;
+	free(jobs);
+	
+	if (!ok)
+		LOG(FATAL, "%s(): %s", __func__, "Error al escribir la matriz.");
+	
+	return offset;
+}
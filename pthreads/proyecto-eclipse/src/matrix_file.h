@@ -0,0 +1,174 @@
+#ifndef MATRIX_FILE_H_
+#define MATRIX_FILE_H_
+
+#include <stdint.h>
+
+#include "matrix.h"
+#include "pool.h"
+
+/*
+ * Formato binario de matrices: una cabecera de
+ * MATRIX_FILE_HEADER_SIZE bytes seguida, a partir de
+ * "data_offset", de los elementos por filas con
+ * dimensión principal "ld" (rows * ld elementos, en
+ * el orden de bytes del equipo que lo escribió).
+ *
+ * Como data_offset es múltiplo de una línea de caché
+ * y las proyecciones comienzan en un límite de
+ * página, el archivo se proyecta directamente como
+ * el bloque de elementos de una matriz_t, sin copias.
+ */
+#define MATRIX_FILE_MAGIC       "MMULTBIN"
+#define MATRIX_FILE_VERSION     1
+#define MATRIX_FILE_HEADER_SIZE 64
+
+/*
+ * Valor de "byte_order": un archivo escrito con el
+ * otro orden de bytes lo tiene invertido.
+ */
+#define MATRIX_FILE_BYTE_ORDER 0x01020304u
+
+/*
+ * Tipos de elementos.
+ */
+#define MATRIX_FILE_UINT32 1
+#define MATRIX_FILE_FLOAT  2
+
+#ifdef FLOAT
+    #define MATRIX_FILE_ELEM_TYPE MATRIX_FILE_FLOAT
+#else
+    #define MATRIX_FILE_ELEM_TYPE MATRIX_FILE_UINT32
+#endif
+
+/*
+ * Cabecera del archivo.
+ */
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t elem_type;
+	uint32_t elem_size;
+	uint32_t rows;
+	uint32_t cols;
+	uint32_t ld;
+	uint32_t reserved0;
+	uint64_t data_offset;
+	uint8_t reserved[16];
+} matrix_file_header_t;
+
+/*
+ * Los archivos que no comienzan con MATRIX_FILE_MAGIC
+ * se leen como texto, con el formato que escribe
+ * matrix_print(): una fila por línea y cada elemento
+ * seguido de un tabulador.
+ */
+
+/*
+ * Trozos del archivo de texto por hilo, para
+ * repartir la búsqueda de las filas en el pool.
+ */
+#define MATRIX_TEXT_CHUNKS_PER_THREAD 4
+
+/*
+ * Obtiene las dimensiones de la matriz del archivo
+ * "path" y las guarda en "rows" y "cols". De un
+ * archivo binario se valida la cabecera (incluido
+ * que el tipo de elementos sea el de matrix_elem_t y
+ * que el archivo contenga todos los datos); de uno de
+ * texto se cuentan las líneas y los elementos de la
+ * primera. Retorna false (indicando el motivo) si no
+ * es un archivo de matrices válido.
+ */
+bool matrix_file_info(const char *path, int *rows, int *cols);
+
+/*
+ * Crea una matriz con el contenido del archivo
+ * "path": si es binario, con matrix_file_map(); si es
+ * de texto, se proyecta y se convierte repartiendo
+ * la búsqueda de las filas y su conversión entre los
+ * "thread_count" hilos de "pool" (si no es nulo).
+ */
+void matrix_file_load(matrix_t **mat, const char *path, pool_t *pool, int thread_count);
+
+/*
+ * Crea una matriz cuyo bloque de elementos es la
+ * proyección (mmap) de los datos del archivo "path".
+ * Las páginas se leen del archivo recién al accederlas.
+ * Las escrituras sobre la matriz no modifican el
+ * archivo. Se destruye con matrix_destroy().
+ */
+void matrix_file_map(matrix_t **mat, const char *path);
+
+/*
+ * Guarda la matriz en el archivo "path" con el
+ * formato binario (el relleno de cada fila, en cero).
+ */
+void matrix_file_write(matrix_t *mat, const char *path);
+
+/*
+ * Abre el archivo binario "path" para leerlo por
+ * bloques con matrix_file_read_block(), y guarda su
+ * cabecera (ya validada) en "header". Retorna el
+ * descriptor, que se cierra con close(2).
+ */
+int matrix_file_open(const char *path, matrix_file_header_t *header);
+
+/*
+ * Crea el archivo binario "path" para una matriz de
+ * rows x cols, con los elementos (y el relleno) en
+ * cero, para escribirlo por bloques con
+ * matrix_file_write_block(). Guarda su cabecera en
+ * "header" y retorna el descriptor.
+ */
+int matrix_file_create(const char *path, int rows, int cols, matrix_file_header_t *header);
+
+/*
+ * Lee en "block" el bloque de block->rows x block->cols
+ * elementos del archivo que comienza en la fila "row"
+ * y la columna "col". Retorna false si no se pudo leer.
+ */
+bool matrix_file_read_block(int fd, const matrix_file_header_t *header, int row, 
+		int col, matrix_t *block);
+
+/*
+ * Escribe "block" en el archivo a partir de la fila
+ * "row" y la columna "col". Retorna false si no se
+ * pudo escribir.
+ */
+bool matrix_file_write_block(int fd, const matrix_file_header_t *header, int row, 
+		int col, matrix_t *block);
+
+/*
+ * Franjas de filas por hilo de la escritura
+ * de texto.
+ */
+#define MATRIX_PRINT_BANDS_PER_THREAD 4
+
+/*
+ * Escribe la matriz en el descriptor "fd" a partir
+ * del desplazamiento "offset", con el mismo texto que
+ * matrix_print(), y retorna el desplazamiento
+ * siguiente. Cada hilo de "pool" (si no es nulo)
+ * convierte franjas de filas en un buffer propio, y
+ * cada franja se escribe con pwrite() en su posición
+ * (la suma de los tamaños de las anteriores).
+ */
+off_t matrix_file_print(matrix_t *mat, int fd, off_t offset, pool_t *pool,
+		int thread_count);
+
+/*
+ * Igual que matrix_file_print(), pero solo para las
+ * filas [row_begin, row_end).
+ */
+off_t matrix_file_print_rows(matrix_t *mat, int row_begin, int row_end, int fd,
+		off_t offset, pool_t *pool, int thread_count);
+
+/*
+ * Escribe "count" bytes de "buf" en el descriptor
+ * "fd" a partir de "offset" (reintentando las
+ * escrituras parciales). Retorna false si falla.
+ */
+bool matrix_file_pwrite(int fd, const void *buf, size_t count, off_t offset);
+
+#endif /*MATRIX_FILE_H_*/
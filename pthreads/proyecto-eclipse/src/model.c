@@ -0,0 +1,115 @@
+#include "model.h"
+
+/*
+ * Completa "size" al múltiplo de "step" siguiente.
+ */
+static double round_up(int size, int step) {
+	return DOUBLE((size + step - 1) / step) * step;
+}
+
+bool model_predict(const roofline_t *roof, int m, int k, int n, int distrib_type,
+		int thread_count, model_plan_t *plan) {
+	
+	const gemm_kernel_t *kernel = gemm_kernel_get();
+	int block_m, block_n, block_k, cpus, tandas, niveles;
+	double ancho_banda;
+	
+	plan->distrib_type = distrib_type;
+	plan->thread_count = thread_count;
+	plan->grid_rows    = 1;
+	plan->grid_cols    = 1;
+	plan->grid_depth   = 1;
+	
+	if (thread_count < 1)
+		return false;
+	
+	/*
+	 * Grilla de cada particionamiento, la misma que
+	 * usará distribute().
+	 */
+	if (distrib_type == 1) {
+		if (thread_count > m)
+			return false;
+		plan->grid_rows = thread_count;
+	}
+	else if (distrib_type == 2) {
+		if (!grid_2d_shape(m, n, thread_count, &plan->grid_rows, &plan->grid_cols))
+			return false;
+	}
+	else if (distrib_type == 4) {
+		if (!grid_3d_shape(m, n, k, thread_count, &plan->grid_rows, &plan->grid_cols,
+						   &plan->grid_depth) || plan->grid_depth == 1)
+			return false;
+	}
+	else
+		return false;
+	
+	/*
+	 * Bloque del hilo más cargado: en 1d el último
+	 * recibe todas las filas sobrantes, en 2d y 3d
+	 * ninguno recibe más de una extra.
+	 */
+	if (distrib_type == 1)
+		block_m = m / thread_count + m % thread_count;
+	else
+		block_m = (m + plan->grid_rows - 1) / plan->grid_rows;
+	block_n = (n + plan->grid_cols - 1) / plan->grid_cols;
+	block_k = (k + plan->grid_depth - 1) / plan->grid_depth;
+	
+	/*
+	 * Con más hilos que procesadores, los hilos se
+	 * ejecutan en tandas. El ancho de banda de memoria
+	 * se supone proporcional a los procesadores usados.
+	 */
+	cpus        = MAX(roof->cpu_count, 1);
+	tandas      = (thread_count + cpus - 1) / cpus;
+	ancho_banda = roof->bandwidth * MIN(thread_count, cpus) / cpus;
+	
+	plan->compute = tandas * MATRIX_MULT_OPS(round_up(block_m, kernel->mr), block_k,
+			round_up(block_n, kernel->nr)) / roof->peak_core;
+	plan->memory  = thread_count * roofline_traffic(block_m, block_k, block_n) / 
+			ancho_banda;
+	
+	/*
+	 * La reducción en árbol lee dos y escribe una C
+	 * por cada parcial, con una espera por nivel.
+	 */
+	plan->reduction = 0.0;
+	if (plan->grid_depth > 1) {
+		for (niveles=0; (1 << niveles) < plan->grid_depth; niveles++)
+			;
+		plan->reduction = 3.0 * (plan->grid_depth - 1) * m * n * sizeof(matrix_elem_t) /
+				ancho_banda + niveles * MODEL_TASK_NANOS;
+	}
+	
+	plan->overhead  = MODEL_TASK_NANOS * thread_count;
+	plan->predicted = MAX(plan->compute, plan->memory) + plan->reduction + 
+			plan->overhead;
+	
+	return true;
+}
+
+void model_choose(const roofline_t *roof, int m, int k, int n, int max_threads,
+		model_plan_t *plan) {
+	
+	static const int tipos[] = {1, 2, 4};
+	model_plan_t candidato;
+	bool encontrado = false;
+	int hilos, t;
+	
+	for (hilos=1; hilos <= MAX(max_threads, 1); hilos++) {
+		for (t=0; t < (int) (sizeof(tipos) / sizeof(tipos[0])); t++) {
+			if (!model_predict(roof, m, k, n, tipos[t], hilos, &candidato))
+				continue;
+			
+			if (!encontrado || candidato.predicted < plan->predicted) {
+				*plan      = candidato;
+				encontrado = true;
+			}
+		}
+	}
+	
+	// Con un hilo 1d siempre es aplicable
+	if (!encontrado)
+		model_predict(roof, m, k, n, 1, 1, plan);
+}
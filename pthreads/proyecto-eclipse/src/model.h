@@ -0,0 +1,57 @@
+#ifndef MODEL_H_
+#define MODEL_H_
+
+#include "config.h"
+
+/*
+ * Costo (en nanosegundos) de despachar un trabajo
+ * al pool. Los trabajos se encolan de a uno, por lo
+ * que el costo crece con la cantidad de hilos.
+ */
+#define MODEL_TASK_NANOS 2000.0
+
+/*
+ * Configuración elegida por el modelo y sus
+ * tiempos estimados (en nanosegundos):
+ *   compute:   cómputo del hilo más cargado, con las
+ *              filas y columnas completadas al tamaño
+ *              del micro-núcleo, a razón del pico de un
+ *              núcleo (en tandas si hay más hilos que
+ *              procesadores).
+ *   memory:    tráfico de todos los hilos (ver
+ *              roofline_traffic()) al ancho de banda
+ *              disponible para esa cantidad de hilos.
+ *   reduction: suma de las C parciales (3d).
+ *   overhead:  despacho de los trabajos (uno por hilo).
+ *   predicted: max(compute, memory) + reduction + overhead.
+ */
+typedef struct {
+	int distrib_type;
+	int thread_count;
+	int grid_rows, grid_cols, grid_depth;
+	double compute;
+	double memory;
+	double reduction;
+	double overhead;
+	double predicted;
+} model_plan_t;
+
+/*
+ * Estima el tiempo de C = A x B (A de m x k, B de
+ * k x n) con el particionamiento "distrib_type" (1d,
+ * 2d o 3d) y "thread_count" hilos. Retorna false si
+ * el particionamiento no admite esa cantidad de hilos.
+ */
+bool model_predict(const roofline_t *roof, int m, int k, int n, int distrib_type,
+		int thread_count, model_plan_t *plan);
+
+/*
+ * Elige el particionamiento (1d, 2d o 3d), su grilla
+ * y la cantidad de hilos (entre 1 y "max_threads")
+ * de menor tiempo estimado. Ante empates se prefiere
+ * el particionamiento más simple y menos hilos.
+ */
+void model_choose(const roofline_t *roof, int m, int k, int n, int max_threads,
+		model_plan_t *plan);
+
+#endif /*MODEL_H_*/
@@ -0,0 +1,337 @@
+#include "morton.h"
+
+/*
+ * Trabajo de la conversión: franja de filas de
+ * bloques [tile_begin, tile_end).
+ */
+typedef struct {
+	morton_t *z;
+	matrix_t *mat;
+	int tile_begin;
+	int tile_end;
+} morton_copy_args;
+
+/*
+ * Trabajo de la multiplicación: bloques de C
+ * [i0, i1) x [j0, j1), con todos los de A y B
+ * que les corresponden.
+ */
+typedef struct {
+	morton_t *a, *b, *c;
+	int i0, i1;
+	int j0, j1;
+} morton_mult_args;
+
+/*
+ * Lado de bloque y cantidad de bloques (potencia de
+ * dos) para una dimensión: la menor grilla cuyos
+ * bloques no superan MORTON_MAX_TILE.
+ */
+static void tile_shape(int size, int *tile, int *grid) {
+	*grid = 1;
+	while ((size + *grid - 1) / *grid > MORTON_MAX_TILE)
+		*grid *= 2;
+	
+	*tile = (size + *grid - 1) / *grid;
+	*tile = (*tile + MORTON_TILE_ALIGN - 1) / MORTON_TILE_ALIGN * MORTON_TILE_ALIGN;
+}
+
+/*
+ * Códigos Morton de las filas (o columnas) de una
+ * grilla de 2^bits x 2^other_bits bloques. Los bits
+ * comunes se intercalan (el de fila es el más
+ * significativo de cada par), y los que sobran de
+ * la dimensión mayor quedan por encima.
+ */
+static int *morton_codes(int bits, int other_bits, bool is_row) {
+	int count = 1 << bits, comunes = MIN(bits, other_bits);
+	int *codes = GET_MEM(int, count);
+	int i, bit;
+	
+	for (i=0; i < count; i++) {
+		codes[i] = 0;
+		for (bit=0; bit < bits; bit++) {
+			if (!(i & (1 << bit)))
+				continue;
+			
+			if (bit < comunes)
+				codes[i] |= 1 << (2 * bit + (is_row ? 1 : 0));
+			else
+				codes[i] |= 1 << (comunes + bit);
+		}
+	}
+	
+	return codes;
+}
+
+static int log2_int(int x) {
+	int bits = 0;
+	
+	while ((1 << bits) < x)
+		bits++;
+	
+	return bits;
+}
+
+/*
+ * Primer elemento del bloque (i, j).
+ */
+static matrix_elem_t *tile_ptr(const morton_t *z, int i, int j) {
+	return z->elements + (size_t) (z->row_code[i] | z->col_code[j]) *
+			z->tile_rows * z->tile_cols;
+}
+
+void morton_create(morton_t **z, int nrows, int ncols) {
+	size_t size;
+	int row_bits, col_bits;
+	
+	if (nrows <= 0 || ncols <= 0)
+		LOG(FATAL, "%s(): %s", __func__, "El número de filas y/o columnas debe ser positivo.");
+	
+	(*z) = GET_MEM(morton_t, 1);
+	(*z)->rows = nrows;
+	(*z)->cols = ncols;
+	
+	tile_shape(nrows, &(*z)->tile_rows, &(*z)->grid_rows);
+	tile_shape(ncols, &(*z)->tile_cols, &(*z)->grid_cols);
+	
+	row_bits = log2_int((*z)->grid_rows);
+	col_bits = log2_int((*z)->grid_cols);
+	(*z)->row_code = morton_codes(row_bits, col_bits, true);
+	(*z)->col_code = morton_codes(col_bits, row_bits, false);
+	
+	size = (size_t) (*z)->grid_rows * (*z)->tile_rows * (*z)->grid_cols * (*z)->tile_cols;
+	(*z)->elements = GET_MEM_ALIGNED(matrix_elem_t, size);
+	memset((*z)->elements, 0, size * sizeof(matrix_elem_t));
+}
+
+void morton_destroy(morton_t *z) {
+	free(z->elements);
+	free(z->row_code);
+	free(z->col_code);
+	free(z);
+}
+
+/*
+ * Copia la franja de bloques de la matriz por
+ * filas a la Morton (el relleno queda en cero).
+ */
+static void copy_to_morton(void *args) {
+	morton_copy_args *aux = (morton_copy_args *) args;
+	morton_t *z = aux->z;
+	matrix_elem_t *tile;
+	int ti, tj, r, row, col, count;
+	
+	for (ti=aux->tile_begin; ti < aux->tile_end; ti++)
+	for (tj=0; tj < z->grid_cols; tj++) {
+		tile  = tile_ptr(z, ti, tj);
+		col   = tj * z->tile_cols;
+		count = MAX(0, MIN(z->tile_cols, z->cols - col));
+		
+		for (r=0; r < z->tile_rows; r++) {
+			row = ti * z->tile_rows + r;
+			if (row < z->rows && count > 0)
+				memcpy(tile + r * z->tile_cols, matrix_row(aux->mat, row) + col,
+						count * sizeof(matrix_elem_t));
+			else
+				count = 0;
+			
+			memset(tile + r * z->tile_cols + count, 0,
+					(z->tile_cols - count) * sizeof(matrix_elem_t));
+		}
+	}
+}
+
+/*
+ * Copia la franja de bloques de la matriz Morton
+ * a la matriz por filas.
+ */
+static void copy_from_morton(void *args) {
+	morton_copy_args *aux = (morton_copy_args *) args;
+	morton_t *z = aux->z;
+	matrix_elem_t *tile;
+	int ti, tj, r, row, col, count;
+	
+	for (ti=aux->tile_begin; ti < aux->tile_end; ti++)
+	for (tj=0; tj < z->grid_cols; tj++) {
+		tile  = tile_ptr(z, ti, tj);
+		col   = tj * z->tile_cols;
+		count = MIN(z->tile_cols, z->cols - col);
+		
+		for (r=0; r < z->tile_rows && count > 0; r++) {
+			row = ti * z->tile_rows + r;
+			if (row >= z->rows)
+				break;
+			
+			memcpy(matrix_row(aux->mat, row) + col, tile + r * z->tile_cols,
+					count * sizeof(matrix_elem_t));
+		}
+	}
+}
+
+/*
+ * Reparte la copia por franjas de filas de bloques.
+ */
+static void morton_copy(morton_t *z, matrix_t *mat, pool_t *pool, int thread_count,
+		pool_fn fn) {
+	
+	morton_copy_args *args;
+	int i, count;
+	
+	if (matrix_rows(mat) != z->rows || matrix_cols(mat) != z->cols)
+		LOG(FATAL, "%s(): %s", __func__, "Las dimensiones de las matrices no coinciden.");
+	
+	count = pool != NULL ? MIN(MAX(thread_count, 1), z->grid_rows) : 1;
+	args  = GET_MEM(morton_copy_args, count);
+	
+	for (i=0; i < count; i++) {
+		args[i].z          = z;
+		args[i].mat        = mat;
+		args[i].tile_begin = z->grid_rows * i / count;
+		args[i].tile_end   = z->grid_rows * (i + 1) / count;
+		
+		if (pool != NULL)
+			pool_submit(pool, fn, &args[i]);
+		else
+			fn(&args[i]);
+	}
+	
+	if (pool != NULL)
+		pool_wait(pool);
+	free(args);
+}
+
+void morton_from_matrix(morton_t *z, matrix_t *mat, pool_t *pool, int thread_count) {
+	morton_copy(z, mat, pool, thread_count, copy_to_morton);
+}
+
+void matrix_from_morton(matrix_t *mat, morton_t *z, pool_t *pool, int thread_count) {
+	morton_copy(z, mat, pool, thread_count, copy_from_morton);
+}
+
+/*
+ * Vista de un bloque como matriz por filas de
+ * rows x cols (la dimensión principal es cols).
+ */
+static matrix_t tile_view(matrix_elem_t *tile, int rows, int cols) {
+	matrix_t view;
+	
+	view.elements = tile;
+	view.rows     = rows;
+	view.cols     = cols;
+	view.ld       = cols;
+	
+	return view;
+}
+
+/*
+ * C += A x B sobre un bloque de cada matriz (tm x tk
+ * por tk x tn), con el micro-núcleo seleccionado.
+ */
+static void tile_mult(matrix_elem_t *a, matrix_elem_t *b, matrix_elem_t *c,
+		int tm, int tk, int tn) {
+	
+	matrix_t tile_a = tile_view(a, tm, tk);
+	matrix_t tile_b = tile_view(b, tk, tn);
+	matrix_t tile_c = tile_view(c, tm, tn);
+	
+	gemm_mult(&tile_a, &tile_b, &tile_c, 0, tm, 0, tn);
+}
+
+/*
+ * C[i0:i1, j0:j1] += A[i0:i1, l0:l1] x B[l0:l1, j0:j1]
+ * (en bloques), dividiendo a la mitad la mayor de
+ * las tres dimensiones hasta llegar a un bloque. Se
+ * omiten los bloques que son todo relleno.
+ */
+static void morton_rec(morton_t *a, morton_t *b, morton_t *c, int i0, int i1,
+		int j0, int j1, int l0, int l1) {
+	
+	int m = i1 - i0, n = j1 - j0, k = l1 - l0;
+	
+	if (i0 * c->tile_rows >= c->rows || j0 * c->tile_cols >= c->cols ||
+			l0 * a->tile_cols >= a->cols)
+		return;
+	
+	if (m == 1 && n == 1 && k == 1)
+		tile_mult(tile_ptr(a, i0, l0), tile_ptr(b, l0, j0), tile_ptr(c, i0, j0),
+				c->tile_rows, a->tile_cols, c->tile_cols);
+	else if (m >= n && m >= k) {
+		morton_rec(a, b, c, i0, i0 + m / 2, j0, j1, l0, l1);
+		morton_rec(a, b, c, i0 + m / 2, i1, j0, j1, l0, l1);
+	}
+	else if (n >= k) {
+		morton_rec(a, b, c, i0, i1, j0, j0 + n / 2, l0, l1);
+		morton_rec(a, b, c, i0, i1, j0 + n / 2, j1, l0, l1);
+	}
+	else {
+		morton_rec(a, b, c, i0, i1, j0, j1, l0, l0 + k / 2);
+		morton_rec(a, b, c, i0, i1, j0, j1, l0 + k / 2, l1);
+	}
+}
+
+static void morton_mult_thread(void *args) {
+	morton_mult_args *aux = (morton_mult_args *) args;
+	
+	morton_rec(aux->a, aux->b, aux->c, aux->i0, aux->i1, aux->j0, aux->j1,
+			0, aux->a->grid_cols);
+}
+
+/*
+ * Divide los bloques de C [i0, i1) x [j0, j1) a la
+ * mitad (por la mayor dimensión) hasta tener "parts"
+ * trabajos o llegar a un bloque.
+ */
+static void split_tasks(morton_mult_args *tasks, int *count, morton_mult_args task,
+		int parts) {
+	
+	morton_mult_args mitad = task;
+	
+	if (parts <= 1 || (task.i1 - task.i0 == 1 && task.j1 - task.j0 == 1)) {
+		tasks[(*count)++] = task;
+		return;
+	}
+	
+	if (task.i1 - task.i0 >= task.j1 - task.j0) {
+		task.i1  = task.i0 + (task.i1 - task.i0) / 2;
+		mitad.i0 = task.i1;
+	}
+	else {
+		task.j1  = task.j0 + (task.j1 - task.j0) / 2;
+		mitad.j0 = task.j1;
+	}
+	
+	split_tasks(tasks, count, task, parts / 2);
+	split_tasks(tasks, count, mitad, parts - parts / 2);
+}
+
+void morton_mult(morton_t *a, morton_t *b, morton_t *c, pool_t *pool, int thread_count) {
+	morton_mult_args todo, *tasks;
+	int parts, count = 0, i;
+	
+	if (a->cols != b->rows || c->rows != a->rows || c->cols != b->cols)
+		LOG(FATAL, "%s(): %s", __func__, "Las dimensiones de las matrices no coinciden.");
+	
+	todo.a  = a;
+	todo.b  = b;
+	todo.c  = c;
+	todo.i0 = 0;
+	todo.i1 = c->grid_rows;
+	todo.j0 = 0;
+	todo.j1 = c->grid_cols;
+	
+	if (pool == NULL) {
+		morton_mult_thread(&todo);
+		return;
+	}
+	
+	parts = MORTON_TASKS_PER_THREAD * MAX(thread_count, 1);
+	tasks = GET_MEM(morton_mult_args, parts);
+	split_tasks(tasks, &count, todo, parts);
+	
+	for (i=0; i < count; i++)
+		pool_submit(pool, morton_mult_thread, &tasks[i]);
+	pool_wait(pool);
+	
+	free(tasks);
+}
@@ -0,0 +1,81 @@
+#ifndef MORTON_H_
+#define MORTON_H_
+
+#include "matrix.h"
+#include "gemm.h"
+#include "pool.h"
+
+/*
+ * Lado máximo (en elementos) de un bloque. Los
+ * lados son múltiplo de MORTON_TILE_ALIGN, de modo
+ * que cada fila de un bloque ocupa líneas de caché
+ * completas.
+ */
+#define MORTON_MAX_TILE 256
+#define MORTON_TILE_ALIGN ((int) (CACHE_LINE_SIZE / sizeof(matrix_elem_t)))
+
+/*
+ * Trabajos de la multiplicación por hilo, para
+ * repartir la carga en el pool.
+ */
+#define MORTON_TASKS_PER_THREAD 4
+
+/*
+ * Matriz almacenada por bloques en orden Morton
+ * (curva Z).
+ *
+ * La matriz se divide en una grilla de grid_rows x
+ * grid_cols bloques (potencias de dos) de tile_rows x
+ * tile_cols elementos; cada bloque se guarda contiguo
+ * y por filas, y los bloques se ordenan intercalando
+ * los bits de su fila y su columna: los cuatro
+ * cuadrantes de cualquier nivel quedan contiguos
+ * (arriba a la izquierda, arriba a la derecha, abajo
+ * a la izquierda, abajo a la derecha). El relleno
+ * (fuera de rows x cols) es cero.
+ *
+ * El bloque (i, j) comienza en el bloque número
+ * row_code[i] | col_code[j].
+ */
+typedef struct {
+	matrix_elem_t *elements;
+	int rows;
+	int cols;
+	int tile_rows, tile_cols;
+	int grid_rows, grid_cols;
+	int *row_code;
+	int *col_code;
+} morton_t;
+
+/*
+ * Crea una matriz Morton de nrows x ncols con
+ * todos sus elementos en cero. Dos matrices con
+ * la misma cantidad de filas (o columnas) usan
+ * los mismos bloques en esa dimensión.
+ */
+void morton_create(morton_t **z, int nrows, int ncols);
+
+/*
+ * Destruye una matriz Morton.
+ */
+void morton_destroy(morton_t *z);
+
+/*
+ * Copia una matriz por filas a una Morton de las
+ * mismas dimensiones, y viceversa. Si "pool" no es
+ * nulo, la copia se reparte entre sus "thread_count"
+ * hilos por franjas de bloques.
+ */
+void morton_from_matrix(morton_t *z, matrix_t *mat, pool_t *pool, int thread_count);
+void matrix_from_morton(matrix_t *mat, morton_t *z, pool_t *pool, int thread_count);
+
+/*
+ * Acumula en C el producto A x B con un algoritmo
+ * recursivo (divide a la mitad la mayor dimensión,
+ * en bloques) independiente de los tamaños de caché.
+ * Si "pool" no es nulo, los bloques de C se reparten
+ * entre sus "thread_count" hilos.
+ */
+void morton_mult(morton_t *a, morton_t *b, morton_t *c, pool_t *pool, int thread_count);
+
+#endif /*MORTON_H_*/
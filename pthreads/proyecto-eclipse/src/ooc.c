@@ -0,0 +1,479 @@
+#include "ooc.h"
+
+/*
+ * Paso del recorrido: la franja "p" de la dimensión
+ * común del bloque (i, j) de C, número "tile" del
+ * recorrido. load_a y load_b indican si la franja de
+ * A o de B debe cargarse (o es la del paso anterior),
+ * y *_slot el buffer que ocupa cada una.
+ */
+typedef struct {
+	int i, j, p;
+	long long tile;
+	bool first, last;
+	bool load_a, load_b;
+	int a_slot, b_slot, c_slot;
+} ooc_step_t;
+
+typedef struct ooc ooc_t;
+
+/*
+ * Hilo de entrada o salida con un único pedido
+ * pendiente: procesa "step" con fn() mientras "busy"
+ * es verdadero.
+ */
+typedef struct {
+	ooc_t *ooc;
+	void (*fn)(ooc_t *ooc, const ooc_step_t *step);
+	ooc_step_t step;
+	bool busy;
+	bool shutdown;
+	long long nanos;
+	
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+} ooc_io_t;
+
+/*
+ * Estado de la multiplicación: archivos, buffers
+ * (con una vista del tamaño de la franja o bloque
+ * que contiene cada uno) e hilos de entrada y salida.
+ */
+struct ooc {
+	ooc_plan_t *plan;
+	int m, k, n;
+	
+	int fd_a, fd_b, fd_c;
+	matrix_file_header_t header_a, header_b, header_c;
+	
+	matrix_t *a_buf[2], *b_buf[2], *c_buf[2];
+	matrix_t a_view[2], b_view[2], c_view[2];
+	
+	ooc_io_t reader;
+	ooc_io_t writer;
+	bool read_ok;
+	bool write_ok;
+	long long read_bytes;
+	long long written_bytes;
+};
+
+/*
+ * Trabajo de la multiplicación de una franja:
+ * filas [row_begin, row_begin + row_count) del
+ * bloque de C.
+ */
+typedef struct {
+	matrix_t *a, *b, *c;
+	int row_begin;
+	int row_count;
+} ooc_mult_args;
+
+/*
+ * Cantidad de elementos de una fila de "cols"
+ * columnas, con el relleno de matrix_alloc().
+ */
+static size_t padded(int cols) {
+	int line_elems = CACHE_LINE_SIZE / sizeof(matrix_elem_t);
+	
+	return (size_t) (cols + line_elems - 1) / line_elems * line_elems;
+}
+
+/*
+ * Cantidad de partes de "size" elementos de a lo
+ * sumo "part" elementos.
+ */
+static int parts(int size, int part) {
+	return (size + part - 1) / part;
+}
+
+bool ooc_plan(int m, int k, int n, size_t budget, ooc_plan_t *plan) {
+	size_t es = sizeof(matrix_elem_t);
+	int line_elems = CACHE_LINE_SIZE / sizeof(matrix_elem_t);
+	int mt, nt, kt, mb, nb, kb, prev_mb;
+	size_t fixed, per_col, max_nb;
+	long long steps, a_loads, b_loads;
+	double read, write, cost, best = -1;
+	
+	/*
+	 * Para cada ancho de franja de la dimensión común
+	 * (k, k/2, k/4, ...) y cada alto de bloque de C, se
+	 * toma el bloque más ancho cuyos buffers caben en
+	 * el presupuesto: 2 (mb x kb) de A, 2 (kb x nb) de B
+	 * y 2 (mb x nb) de C.
+	 */
+	for (kb=k; ; kb = (kb + 1) / 2) {
+		kt = parts(k, kb);
+		kb = parts(k, kt);
+		
+		for (mt=1, prev_mb=0; mt <= m; mt++) {
+			mb = parts(m, mt);
+			if (mb == prev_mb)
+				continue;
+			prev_mb = mb;
+			
+			fixed   = 2 * (size_t) mb * padded(kb) * es;
+			per_col = 2 * (size_t) (kb + mb) * es;
+			if (fixed + per_col * line_elems > budget)
+				continue;
+			
+			max_nb = (budget - fixed) / per_col;
+			if (max_nb >= padded(n))
+				nb = n;
+			else
+				nb = (int) (max_nb / line_elems * line_elems);
+			
+			nt = parts(n, nb);
+			nb = parts(n, nt);
+			
+			/*
+			 * En zigzag, cada bloque de la misma fila reutiliza
+			 * una franja de A y cada cambio de fila una de B.
+			 */
+			steps   = (long long) parts(m, mb) * nt * kt;
+			a_loads = steps - (long long) parts(m, mb) * (nt - 1);
+			b_loads = steps - (parts(m, mb) - 1);
+			
+			read  = (a_loads * ((double) m / parts(m, mb)) * ((double) k / kt) +
+					b_loads * ((double) k / kt) * ((double) n / nt)) * es;
+			write = (double) m * n * es;
+			cost  = read + write + (double) steps * OOC_STEP_BYTES;
+			
+			if (best < 0 || cost < best) {
+				best = cost;
+				
+				plan->row_panels   = parts(m, mb);
+				plan->col_panels   = nt;
+				plan->depth_panels = kt;
+				plan->mb           = mb;
+				plan->nb           = nb;
+				plan->kb           = kb;
+				plan->memory       = 2 * ((size_t) mb * padded(kb) + (size_t) kb * padded(nb) +
+									 (size_t) mb * padded(nb)) * es;
+				plan->read_bytes   = read;
+				plan->write_bytes  = write;
+				plan->steps        = steps;
+			}
+		}
+		
+		if (kb == 1)
+			break;
+	}
+	
+	return best >= 0;
+}
+
+/*
+ * Calcula el paso "s" del recorrido a partir del
+ * anterior ("prev", nulo para el primero).
+ */
+static void step_at(const ooc_plan_t *plan, long long s, const ooc_step_t *prev,
+		ooc_step_t *step) {
+	
+	long long tile = s / plan->depth_panels;
+	int pp = (int) (s % plan->depth_panels);
+	int jj = (int) (tile % plan->col_panels);
+	
+	step->tile  = tile;
+	step->i     = (int) (tile / plan->col_panels);
+	step->j     = step->i % 2 == 0 ? jj : plan->col_panels - 1 - jj;
+	step->p     = tile % 2 == 0 ? pp : plan->depth_panels - 1 - pp;
+	step->first = pp == 0;
+	step->last  = pp == plan->depth_panels - 1;
+	
+	step->c_slot = (int) (tile % 2);
+	if (prev == NULL) {
+		step->load_a = step->load_b = true;
+		step->a_slot = step->b_slot = 0;
+	}
+	else {
+		step->load_a = step->i != prev->i || step->p != prev->p;
+		step->load_b = step->p != prev->p || step->j != prev->j;
+		step->a_slot = step->load_a ? 1 - prev->a_slot : prev->a_slot;
+		step->b_slot = step->load_b ? 1 - prev->b_slot : prev->b_slot;
+	}
+}
+
+/*
+ * Filas o columnas del panel "index" de "size"
+ * elementos, en paneles de "part".
+ */
+static int panel_size(int size, int part, int index) {
+	return MIN(part, size - index * part);
+}
+
+/*
+ * Lector: carga las franjas de A y B del paso.
+ */
+static void read_step(ooc_t *ooc, const ooc_step_t *step) {
+	ooc_plan_t *plan = ooc->plan;
+	matrix_t *a = &ooc->a_view[step->a_slot];
+	matrix_t *b = &ooc->b_view[step->b_slot];
+	
+	if (step->load_a) {
+		matrix_view(a, ooc->a_buf[step->a_slot], panel_size(ooc->m, plan->mb, step->i),
+				panel_size(ooc->k, plan->kb, step->p));
+		ooc->read_ok = ooc->read_ok && matrix_file_read_block(ooc->fd_a, &ooc->header_a,
+				step->i * plan->mb, step->p * plan->kb, a);
+		ooc->read_bytes += (long long) matrix_rows(a) * matrix_cols(a) * sizeof(matrix_elem_t);
+	}
+	if (step->load_b) {
+		matrix_view(b, ooc->b_buf[step->b_slot], panel_size(ooc->k, plan->kb, step->p),
+				panel_size(ooc->n, plan->nb, step->j));
+		ooc->read_ok = ooc->read_ok && matrix_file_read_block(ooc->fd_b, &ooc->header_b,
+				step->p * plan->kb, step->j * plan->nb, b);
+		ooc->read_bytes += (long long) matrix_rows(b) * matrix_cols(b) * sizeof(matrix_elem_t);
+	}
+}
+
+/*
+ * Escritor: guarda el bloque de C del paso.
+ */
+static void write_step(ooc_t *ooc, const ooc_step_t *step) {
+	matrix_t *c = &ooc->c_view[step->c_slot];
+	
+	ooc->write_ok = ooc->write_ok && matrix_file_write_block(ooc->fd_c, &ooc->header_c,
+			step->i * ooc->plan->mb, step->j * ooc->plan->nb, c);
+	ooc->written_bytes += (long long) matrix_rows(c) * matrix_cols(c) * sizeof(matrix_elem_t);
+}
+
+/*
+ * Hilo de entrada o salida: atiende los pedidos
+ * hasta que se lo detiene.
+ */
+static void *io_thread(void *args) {
+	ooc_io_t *io = (ooc_io_t *) args;
+	long long begin;
+	
+	pthread_mutex_lock(&io->mutex);
+	while (true) {
+		while (!io->busy && !io->shutdown)
+			pthread_cond_wait(&io->cond, &io->mutex);
+		if (!io->busy)
+			break;
+		pthread_mutex_unlock(&io->mutex);
+		
+		begin = get_time_nanos();
+		io->fn(io->ooc, &io->step);
+		io->nanos += get_time_nanos() - begin;
+		
+		pthread_mutex_lock(&io->mutex);
+		io->busy = false;
+		pthread_cond_broadcast(&io->cond);
+	}
+	pthread_mutex_unlock(&io->mutex);
+	
+	return NULL;
+}
+
+/*
+ * Crea el hilo, que atenderá sus pedidos con fn().
+ */
+static void io_start(ooc_io_t *io, ooc_t *ooc, void (*fn)(ooc_t *, const ooc_step_t *)) {
+	memset(io, 0, sizeof(ooc_io_t));
+	io->ooc = ooc;
+	io->fn  = fn;
+	
+	pthread_mutex_init(&io->mutex, NULL);
+	pthread_cond_init(&io->cond, NULL);
+	
+	if (pthread_create(&io->thread, NULL, io_thread, io) != 0)
+		LOG(FATAL, "%s(): %s", __func__, "Error en creación del hilo de entrada/salida.");
+}
+
+/*
+ * Encola el paso en el hilo, que debe estar libre.
+ */
+static void io_submit(ooc_io_t *io, const ooc_step_t *step) {
+	pthread_mutex_lock(&io->mutex);
+	io->step = *step;
+	io->busy = true;
+	pthread_cond_broadcast(&io->cond);
+	pthread_mutex_unlock(&io->mutex);
+}
+
+/*
+ * Espera a que el hilo termine su pedido, y
+ * retorna el tiempo esperado.
+ */
+static long long io_wait(ooc_io_t *io) {
+	long long begin = get_time_nanos();
+	
+	pthread_mutex_lock(&io->mutex);
+	while (io->busy)
+		pthread_cond_wait(&io->cond, &io->mutex);
+	pthread_mutex_unlock(&io->mutex);
+	
+	return get_time_nanos() - begin;
+}
+
+/*
+ * Detiene el hilo, que debe estar libre.
+ */
+static void io_stop(ooc_io_t *io) {
+	pthread_mutex_lock(&io->mutex);
+	io->shutdown = true;
+	pthread_cond_broadcast(&io->cond);
+	pthread_mutex_unlock(&io->mutex);
+	
+	if (pthread_join(io->thread, NULL) != 0)
+		LOG(FATAL, "%s(): %s", __func__, "Error en 'join' del hilo de entrada/salida.");
+	
+	pthread_mutex_destroy(&io->mutex);
+	pthread_cond_destroy(&io->cond);
+}
+
+/*
+ * Multiplica un trabajo de filas del bloque de C.
+ */
+static void mult_rows(void *args) {
+	ooc_mult_args *aux = (ooc_mult_args *) args;
+	
+	matrix_mult(aux->a, aux->b, aux->c, aux->row_begin, aux->row_count,
+			0, matrix_cols(aux->c));
+}
+
+/*
+ * Acumula en el bloque de C el producto de las
+ * franjas del paso, repartiendo sus filas entre
+ * los hilos del pool.
+ */
+static void mult_step(ooc_t *ooc, const ooc_step_t *step, pool_t *pool,
+		int thread_count, ooc_mult_args *jobs) {
+	
+	matrix_t *c = &ooc->c_view[step->c_slot];
+	int i, count;
+	
+	count = pool != NULL ? MIN(thread_count, matrix_rows(c)) : 1;
+	for (i=0; i < count; i++) {
+		jobs[i].a         = &ooc->a_view[step->a_slot];
+		jobs[i].b         = &ooc->b_view[step->b_slot];
+		jobs[i].c         = c;
+		jobs[i].row_begin = (int) ((long) matrix_rows(c) * i / count);
+		jobs[i].row_count = (int) ((long) matrix_rows(c) * (i + 1) / count) -
+							jobs[i].row_begin;
+		
+		if (pool != NULL)
+			pool_submit(pool, mult_rows, &jobs[i]);
+		else
+			mult_rows(&jobs[i]);
+	}
+	if (pool != NULL)
+		pool_wait(pool);
+}
+
+void ooc_mult(const char *path_a, const char *path_b, const char *path_c, size_t budget,
+		pool_t *pool, int thread_count, ooc_plan_t *plan, ooc_stats_t *stats) {
+	
+	ooc_t ooc;
+	ooc_step_t actual, siguiente;
+	ooc_mult_args *jobs;
+	long long s, begin, inicio;
+	int slot;
+	
+	memset(&ooc, 0, sizeof(ooc_t));
+	memset(stats, 0, sizeof(ooc_stats_t));
+	
+	ooc.fd_a = matrix_file_open(path_a, &ooc.header_a);
+	ooc.fd_b = matrix_file_open(path_b, &ooc.header_b);
+	ooc.m    = (int) ooc.header_a.rows;
+	ooc.k    = (int) ooc.header_a.cols;
+	ooc.n    = (int) ooc.header_b.cols;
+	
+	if ((int) ooc.header_b.rows != ooc.k)
+		LOG(FATAL, "%s %s", "La cantidad de columnas de la matriz A debe ser",
+				"igual a la cantidad de filas de la matriz B.");
+	
+	if (!ooc_plan(ooc.m, ooc.k, ooc.n, budget, plan))
+		LOG(FATAL, "%s(): %s", __func__, "La memoria disponible no alcanza para los buffers.");
+	ooc.plan = plan;
+	
+	ooc.fd_c = matrix_file_create(path_c, ooc.m, ooc.n, &ooc.header_c);
+	
+	for (slot=0; slot < 2; slot++) {
+		matrix_alloc(&ooc.a_buf[slot], plan->mb, plan->kb);
+		matrix_alloc(&ooc.b_buf[slot], plan->kb, plan->nb);
+		matrix_alloc(&ooc.c_buf[slot], plan->mb, plan->nb);
+	}
+	jobs = GET_MEM(ooc_mult_args, MAX(thread_count, 1));
+	
+	ooc.read_ok  = true;
+	ooc.write_ok = true;
+	io_start(&ooc.reader, &ooc, read_step);
+	io_start(&ooc.writer, &ooc, write_step);
+	
+	/*
+	 * Mientras se multiplica el paso actual, el lector
+	 * carga las franjas del siguiente en los otros
+	 * buffers, y el escritor guarda el bloque de C
+	 * anterior.
+	 */
+	begin = get_time_nanos();
+	
+	step_at(plan, 0, NULL, &actual);
+	io_submit(&ooc.reader, &actual);
+	
+	for (s=0; s < plan->steps; s++) {
+		stats->read_wait += io_wait(&ooc.reader);
+		if (!ooc.read_ok)
+			LOG(FATAL, "%s(): %s", __func__, "Error al leer los archivos de A y B.");
+		
+		if (s + 1 < plan->steps) {
+			step_at(plan, s + 1, &actual, &siguiente);
+			io_submit(&ooc.reader, &siguiente);
+		}
+		
+		/*
+		 * El buffer de C del bloque es el del bloque
+		 * anterior al último, cuya escritura ya se esperó.
+		 */
+		if (actual.first) {
+			matrix_t *c = &ooc.c_view[actual.c_slot];
+			
+			matrix_view(c, ooc.c_buf[actual.c_slot], panel_size(ooc.m, plan->mb, actual.i),
+					panel_size(ooc.n, plan->nb, actual.j));
+			matrix_clear(c, 0, matrix_rows(c), 0, matrix_cols(c));
+		}
+		
+		inicio = get_time_nanos();
+		mult_step(&ooc, &actual, pool, thread_count, jobs);
+		stats->compute += get_time_nanos() - inicio;
+		
+		if (actual.last) {
+			stats->write_wait += io_wait(&ooc.writer);
+			if (!ooc.write_ok)
+				LOG(FATAL, "Error al escribir el archivo de matrices \"%s\".", path_c);
+			
+			io_submit(&ooc.writer, &actual);
+		}
+		
+		if (s + 1 < plan->steps)
+			actual = siguiente;
+	}
+	
+	stats->write_wait += io_wait(&ooc.writer);
+	if (!ooc.write_ok)
+		LOG(FATAL, "Error al escribir el archivo de matrices \"%s\".", path_c);
+	
+	stats->total = get_time_nanos() - begin;
+	
+	io_stop(&ooc.reader);
+	io_stop(&ooc.writer);
+	
+	stats->read          = ooc.reader.nanos;
+	stats->write         = ooc.writer.nanos;
+	stats->read_bytes    = ooc.read_bytes;
+	stats->written_bytes = ooc.written_bytes;
+	
+	close(ooc.fd_a);
+	close(ooc.fd_b);
+	if (close(ooc.fd_c) != 0)
+		LOG(FATAL, "Error al escribir el archivo de matrices \"%s\".", path_c);
+	
+	for (slot=0; slot < 2; slot++) {
+		matrix_destroy(ooc.a_buf[slot]);
+		matrix_destroy(ooc.b_buf[slot]);
+		matrix_destroy(ooc.c_buf[slot]);
+	}
+	free(jobs);
+}
@@ -0,0 +1,103 @@
+#ifndef OOC_H_
+#define OOC_H_
+
+#include "matrix_file.h"
+#include "pool.h"
+
+/*
+ * Multiplicación fuera de memoria: C = A x B con las
+ * tres matrices en archivos binarios (ver
+ * matrix_file.h), para matrices que no caben en la
+ * memoria.
+ *
+ * C se recorre en bloques de mb x nb que permanecen
+ * en memoria mientras se acumulan los productos de
+ * las franjas de kb columnas de A (mb x kb) y kb filas
+ * de B (kb x nb) que les corresponden. Un hilo lector
+ * carga las franjas del paso siguiente mientras se
+ * multiplica (doble buffer de A y de B) y un hilo
+ * escritor guarda cada bloque terminado de C mientras
+ * se calcula el siguiente (doble buffer de C).
+ *
+ * Los bloques de C se recorren en zigzag (las
+ * columnas de bloques alternan su sentido en cada fila
+ * de bloques, y las franjas de la dimensión común en
+ * cada bloque), de modo que cada bloque reutiliza la
+ * última franja de A (en la misma fila) o de B (al
+ * cambiar de fila) del anterior. Si toda la dimensión
+ * común cabe en una franja (kb = k), cada panel de A
+ * se lee una sola vez.
+ */
+
+/*
+ * Costo (en bytes leídos equivalentes) de cada paso
+ * del recorrido: sincronización con los hilos de
+ * entrada y salida y el acceso no secuencial de cada
+ * franja. Entre recorridos con el mismo volumen de
+ * lecturas se prefiere el de menos pasos.
+ */
+#define OOC_STEP_BYTES (1 << 20)
+
+/*
+ * Recorrido elegido y sus estimaciones:
+ *   row_panels, col_panels, depth_panels: cantidad
+ *       de bloques de C por filas y columnas, y de
+ *       franjas de la dimensión común.
+ *   mb, nb, kb: tamaño (máximo) de cada uno.
+ *   memory: bytes de los buffers (dos de cada uno).
+ *   read_bytes, write_bytes: bytes leídos de A y B y
+ *       escritos de C.
+ *   steps: multiplicaciones de franjas.
+ */
+typedef struct {
+	int row_panels, col_panels, depth_panels;
+	int mb, nb, kb;
+	size_t memory;
+	double read_bytes;
+	double write_bytes;
+	long long steps;
+} ooc_plan_t;
+
+/*
+ * Mediciones de una multiplicación fuera de memoria
+ * (tiempos en nanosegundos):
+ *   compute:    multiplicación de las franjas.
+ *   read_wait:  espera de las franjas aún no cargadas
+ *               por el lector.
+ *   write_wait: espera de un buffer de C aún no
+ *               guardado por el escritor.
+ *   read, write: tiempo de trabajo del lector y del
+ *               escritor.
+ *   total:      multiplicación completa.
+ */
+typedef struct {
+	long long read_bytes;
+	long long written_bytes;
+	long long compute;
+	long long read_wait;
+	long long write_wait;
+	long long read;
+	long long write;
+	long long total;
+} ooc_stats_t;
+
+/*
+ * Elige el recorrido de menor costo (bytes leídos y
+ * escritos, más OOC_STEP_BYTES por paso) de C = A x B
+ * (A de m x k, B de k x n) cuyos buffers no superan
+ * "budget" bytes. Retorna false si no hay ninguno.
+ */
+bool ooc_plan(int m, int k, int n, size_t budget, ooc_plan_t *plan);
+
+/*
+ * Multiplica las matrices de los archivos binarios
+ * "path_a" y "path_b" y guarda el resultado en el
+ * archivo binario "path_c", con a lo sumo "budget"
+ * bytes de buffers. Cada franja se multiplica
+ * repartiendo las filas del bloque de C entre los
+ * "thread_count" hilos de "pool" (si no es nulo).
+ */
+void ooc_mult(const char *path_a, const char *path_b, const char *path_c, size_t budget,
+		pool_t *pool, int thread_count, ooc_plan_t *plan, ooc_stats_t *stats);
+
+#endif /*OOC_H_*/
@@ -0,0 +1,234 @@
+#include "pool.h"
+
+/*
+ * Capacidad inicial de las colas de trabajos.
+ */
+#define POOL_INITIAL_CAPACITY 64
+
+/*
+ * Argumento de inicio de cada hilo del pool.
+ */
+typedef struct {
+	pool_t *pool;
+	int index;
+} pool_worker_t;
+
+static void queue_init(pool_queue_t *queue) {
+	queue->capacity = POOL_INITIAL_CAPACITY;
+	queue->jobs     = GET_MEM(pool_job_t, queue->capacity);
+	queue->head     = 0;
+	queue->count    = 0;
+}
+
+/*
+ * Agrega un trabajo al final de la cola. Si está
+ * llena, duplica su capacidad copiando los trabajos
+ * en orden.
+ */
+static void queue_push(pool_queue_t *queue, pool_job_t job) {
+	pool_job_t *jobs;
+	int i;
+	
+	if (queue->count == queue->capacity) {
+		jobs = GET_MEM(pool_job_t, 2 * queue->capacity);
+		for (i=0; i < queue->count; i++)
+			jobs[i] = queue->jobs[(queue->head + i) % queue->capacity];
+		
+		free(queue->jobs);
+		queue->jobs      = jobs;
+		queue->head      = 0;
+		queue->capacity *= 2;
+	}
+	
+	queue->jobs[(queue->head + queue->count) % queue->capacity] = job;
+	queue->count++;
+}
+
+/*
+ * Quita el primer trabajo de la cola.
+ */
+static pool_job_t queue_pop(pool_queue_t *queue) {
+	pool_job_t job = queue->jobs[queue->head];
+	
+	queue->head = (queue->head + 1) % queue->capacity;
+	queue->count--;
+	
+	return job;
+}
+
+/*
+ * Función de cada hilo del pool: toma trabajos de
+ * su cola propia o de la compartida y los ejecuta
+ * hasta que se indique la finalización.
+ */
+static void *pool_worker(void *args) {
+	pool_worker_t *worker = (pool_worker_t *) args;
+	pool_t *pool = worker->pool;
+	pool_queue_t *own = &pool->own[worker->index];
+	pool_job_t job;
+	long long now;
+	
+	free(worker);
+	pthread_mutex_lock(&pool->mutex);
+	
+	for (;;) {
+		while (own->count == 0 && pool->shared.count == 0 && !pool->shutdown)
+			pthread_cond_wait(&pool->job_ready, &pool->mutex);
+		
+		if (own->count == 0 && pool->shared.count == 0 && pool->shutdown)
+			break;
+		
+		// Primero los trabajos propios
+		job = own->count > 0 ? queue_pop(own) : queue_pop(&pool->shared);
+		
+		// Registramos la espera del trabajo
+		now = get_time_nanos();
+		pool->stats.jobs++;
+		pool->stats.latency_sum += now - job.submitted;
+		if (now > pool->stats.last_start)
+			pool->stats.last_start = now;
+		
+		pthread_mutex_unlock(&pool->mutex);
+		job.fn(job.arg);
+		pthread_mutex_lock(&pool->mutex);
+		
+		if (--pool->pending == 0)
+			pthread_cond_broadcast(&pool->all_done);
+	}
+	
+	pthread_mutex_unlock(&pool->mutex);
+	return NULL;
+}
+
+void pool_create(pool_t **pool, int thread_count) {
+	pool_worker_t *worker;
+	int i;
+	
+	if (thread_count <= 0)
+		LOG(FATAL, "%s(): %s", __func__, "La cantidad de hilos debe ser positiva.");
+	
+	(*pool) = GET_MEM(pool_t, 1);
+	memset(*pool, 0, sizeof(pool_t));
+	
+	(*pool)->thread_count = thread_count;
+	(*pool)->own          = GET_MEM(pool_queue_t, thread_count);
+	
+	queue_init(&(*pool)->shared);
+	for (i=0; i < thread_count; i++)
+		queue_init(&(*pool)->own[i]);
+	
+	pthread_mutex_init(&(*pool)->mutex, NULL);
+	pthread_cond_init(&(*pool)->job_ready, NULL);
+	pthread_cond_init(&(*pool)->all_done, NULL);
+	
+	(*pool)->threads = GET_MEM(pthread_t, thread_count);
+	for (i=0; i < thread_count; i++) {
+		worker = GET_MEM(pool_worker_t, 1);
+		worker->pool  = *pool;
+		worker->index = i;
+		
+		int rc = pthread_create(&(*pool)->threads[i], NULL, pool_worker, worker);
+		
+		if (rc != 0)
+			LOG(FATAL, "Error en creación del hilo '%d'", i);
+	}
+}
+
+void pool_destroy(pool_t *pool) {
+	int i;
+	
+	pthread_mutex_lock(&pool->mutex);
+	pool->shutdown = true;
+	pthread_cond_broadcast(&pool->job_ready);
+	pthread_mutex_unlock(&pool->mutex);
+	
+	for (i=0; i < pool->thread_count; i++) {
+		int rc = pthread_join(pool->threads[i], NULL);
+		
+		if (rc != 0)
+			LOG(FATAL, "Error en 'join' del hilo '%d'", i);
+	}
+	
+	pthread_mutex_destroy(&pool->mutex);
+	pthread_cond_destroy(&pool->job_ready);
+	pthread_cond_destroy(&pool->all_done);
+	
+	for (i=0; i < pool->thread_count; i++)
+		free(pool->own[i].jobs);
+	free(pool->own);
+	free(pool->shared.jobs);
+	free(pool->threads);
+	free(pool);
+}
+
+/*
+ * Encola un trabajo en la cola indicada. Si el
+ * trabajo es para un hilo determinado se despiertan
+ * todos los hilos, ya que no se sabe cuál de ellos
+ * recibirá la señal.
+ */
+static void submit(pool_t *pool, pool_queue_t *queue, pool_fn fn, void *arg) {
+	pool_job_t job;
+	
+	pthread_mutex_lock(&pool->mutex);
+	
+	job.fn        = fn;
+	job.arg       = arg;
+	job.submitted = get_time_nanos();
+	
+	if (pool->stats.first_submit == 0)
+		pool->stats.first_submit = job.submitted;
+	
+	queue_push(queue, job);
+	pool->pending++;
+	
+	if (queue == &pool->shared)
+		pthread_cond_signal(&pool->job_ready);
+	else
+		pthread_cond_broadcast(&pool->job_ready);
+	
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+void pool_submit(pool_t *pool, pool_fn fn, void *arg) {
+	submit(pool, &pool->shared, fn, arg);
+}
+
+void pool_submit_to(pool_t *pool, int worker, pool_fn fn, void *arg) {
+	if (worker < 0 || worker >= pool->thread_count)
+		LOG(FATAL, "%s(): Hilo '%d' inexistente.", __func__, worker);
+	
+	submit(pool, &pool->own[worker], fn, arg);
+}
+
+bool pool_pin(pool_t *pool, int worker, int cpu) {
+	cpu_set_t cpus;
+	
+	CPU_ZERO(&cpus);
+	CPU_SET(cpu, &cpus);
+	
+	return pthread_setaffinity_np(pool->threads[worker], sizeof(cpu_set_t), &cpus) == 0;
+}
+
+void pool_wait(pool_t *pool) {
+	pthread_mutex_lock(&pool->mutex);
+	
+	while (pool->pending > 0)
+		pthread_cond_wait(&pool->all_done, &pool->mutex);
+	
+	// Cerramos el lote de estadísticas
+	pool->last_stats = pool->stats;
+	memset(&pool->stats, 0, sizeof(pool_stats_t));
+	
+	pthread_mutex_unlock(&pool->mutex);
+}
+
+pool_stats_t pool_last_stats(pool_t *pool) {
+	pool_stats_t stats;
+	
+	pthread_mutex_lock(&pool->mutex);
+	stats = pool->last_stats;
+	pthread_mutex_unlock(&pool->mutex);
+	
+	return stats;
+}
@@ -0,0 +1,108 @@
+#ifndef POOL_H_
+#define POOL_H_
+
+#include "utils.h"
+
+/*
+ * Función que ejecuta un trabajo del pool.
+ */
+typedef void (*pool_fn)(void *arg);
+
+/*
+ * Trabajo encolado en el pool.
+ */
+typedef struct {
+	pool_fn fn;
+	void *arg;
+	long long submitted;	// Instante en que se encoló
+} pool_job_t;
+
+/*
+ * Estadísticas de despacho de un lote de
+ * trabajos (los encolados desde la última
+ * llamada a pool_wait()).
+ */
+typedef struct {
+	int jobs;				// Trabajos despachados
+	long long first_submit;	// Instante en que se encoló el primero
+	long long last_start;	// Instante en que comenzó el último
+	long long latency_sum;	// Suma de esperas (encolado -> inicio)
+} pool_stats_t;
+
+/*
+ * Cola circular de trabajos.
+ */
+typedef struct {
+	pool_job_t *jobs;
+	int capacity;
+	int head;
+	int count;
+} pool_queue_t;
+
+/*
+ * Pool de hilos persistentes. Los hilos se crean
+ * una sola vez y esperan en una variable de condición
+ * hasta que haya trabajos en la cola compartida o en
+ * su cola propia.
+ */
+typedef struct {
+	pthread_t *threads;
+	int thread_count;
+	
+	pthread_mutex_t mutex;
+	pthread_cond_t job_ready;	// Hay trabajos en alguna cola (o terminar)
+	pthread_cond_t all_done;	// No quedan trabajos pendientes
+	
+	pool_queue_t shared;		// Trabajos para cualquier hilo
+	pool_queue_t *own;			// Trabajos para un hilo determinado
+	int pending;				// Trabajos en cola o en ejecución
+	bool shutdown;
+	
+	pool_stats_t stats;
+	pool_stats_t last_stats;
+} pool_t;
+
+/*
+ * Crea un pool con "thread_count" hilos.
+ */
+void pool_create(pool_t **pool, int thread_count);
+
+/*
+ * Espera a que terminen los trabajos pendientes,
+ * finaliza los hilos y destruye el pool.
+ */
+void pool_destroy(pool_t *pool);
+
+/*
+ * Encola un trabajo. Algún hilo libre del pool
+ * ejecutará fn(arg).
+ */
+void pool_submit(pool_t *pool, pool_fn fn, void *arg);
+
+/*
+ * Encola un trabajo que debe ejecutar el hilo
+ * "worker" del pool (por ejemplo, para que cada
+ * partición se procese siempre en el mismo
+ * procesador).
+ */
+void pool_submit_to(pool_t *pool, int worker, pool_fn fn, void *arg);
+
+/*
+ * Fija el hilo "worker" del pool al procesador
+ * lógico "cpu". Retorna false si no fue posible.
+ */
+bool pool_pin(pool_t *pool, int worker, int cpu);
+
+/*
+ * Espera a que terminen todos los trabajos
+ * encolados, y cierra el lote de estadísticas.
+ */
+void pool_wait(pool_t *pool);
+
+/*
+ * Retorna las estadísticas de despacho del
+ * último lote cerrado con pool_wait().
+ */
+pool_stats_t pool_last_stats(pool_t *pool);
+
+#endif /*POOL_H_*/
@@ -1,84 +1,401 @@
-#include "matrix.h"
+#include "gemm.h"
+#include "pool.h"
+#include "sysinfo.h"
 
-void test_simple();
-void test_mult();
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
-int main_test(int argc, char** argv) {
-    test_simple();
-    test_mult();
-    return (EXIT_SUCCESS);
+/*
+ * Micro-benchmark de los núcleos de multiplicación
+ * (target "bench-kernels" del Makefile). Mide cada
+ * micro-núcleo disponible (vía matrix_mult) y la
+ * variante por bloques sobre formas fijas, con los
+ * hilos fijados a procesadores, repitiendo hasta
+ * que el intervalo de confianza sea estrecho.
+ *
+ * Uso: bench-kernels [-h cantidad_hilos] [-e error_relativo]
+ */
+
+/*
+ * Repeticiones mínimas y máximas de cada caso, y
+ * tiempo máximo (en nanosegundos) dedicado a uno.
+ */
+#define BENCH_MIN_REPS 5
+#define BENCH_MAX_REPS 200
+#define BENCH_MAX_NANOS 3000000000LL
+
+/*
+ * Semi-amplitud relativa del intervalo de confianza
+ * del 95% a partir de la cual se deja de repetir.
+ */
+#define BENCH_DEFAULT_ERROR 0.01
+
+/*
+ * Forma de una multiplicación: C (m x n) += A (m x k) x B (k x n),
+ * repetida "batch" veces sobre matrices distintas.
+ */
+typedef struct {
+	const char *name;
+	int m, k, n;
+	int batch;
+} bench_shape_t;
+
+static const bench_shape_t shapes[] = {
+	{"cuadrada",    512,  512,  512,   1},
+	{"alta",       4096,  256,   64,   1},
+	{"ancha",        64,  256, 4096,   1},
+	{"lote",         32,   32,   32, 256}
+};
+
+#define BENCH_SHAPE_COUNT ((int) (sizeof(shapes) / sizeof(shapes[0])))
+
+/*
+ * Función de multiplicación con la semántica
+ * de matrix_mult().
+ */
+typedef void (*bench_mult_fn)(matrix_t *a, matrix_t *b, matrix_t *c,
+		int row_begin, int row_count, int col_begin, int col_count);
+
+/*
+ * Variante medida: una función de multiplicación
+ * y, si corresponde, el micro-núcleo que usa.
+ */
+typedef struct {
+	char name[32];
+	bench_mult_fn fn;
+	const gemm_kernel_t *kernel;
+} bench_variant_t;
+
+/*
+ * Trabajo de un hilo: las filas [row_begin, row_end)
+ * de cada multiplicación, o bien las multiplicaciones
+ * [batch_begin, batch_end) completas.
+ */
+typedef struct {
+	matrix_t **a, **b, **c;
+	bench_mult_fn fn;
+	int batch_begin, batch_end;
+	int row_begin, row_end;
+	bool counters;
+	long long cycles;	// Ciclos del hilo (-1 si no se midieron)
+} bench_job_t;
+
+/*
+ * Valores críticos de la t de Student (dos colas,
+ * 95%) para 1 a 30 grados de libertad.
+ */
+static const double student_t95[] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static double student_t(int df) {
+	return df <= 30 ? student_t95[MAX(df, 1) - 1] : 1.960;
+}
+
+/*
+ * Ciclos de referencia del procesador (TSC), o -1
+ * si no se pueden leer en esta arquitectura.
+ */
+static long long read_tsc(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	return (long long) __rdtsc();
+#else
+	return -1;
+#endif
 }
 
-void test_simple() {
-    matrix_t *mat;
-    int i=0, j=0;
-    
-    printf("\ntest_simple\n");
-    
-    matrix_create(&mat, 2, 2);
-    matrix_print(mat, stdout);
-    
-    srand(time(NULL));
-    for (i=0; i < matrix_rows(mat); i++)
-    for (j=0; j < matrix_cols(mat); j++)
-        matrix_ref(mat, i, j) = rand() / 1333.33;
-    
-    printf("\n");
-    matrix_print(mat, stdout);
-    matrix_destroy(mat);
+static void bench_job(void *args) {
+	bench_job_t *job = (bench_job_t *) args;
+	counter_set_t set;
+	counters_t valores;
+	bool medir;
+	int i;
+	
+	medir = job->counters && counters_start(&set);
+	
+	for (i=job->batch_begin; i < job->batch_end; i++)
+		job->fn(job->a[i], job->b[i], job->c[i], job->row_begin,
+				job->row_end - job->row_begin, 0, matrix_cols(job->c[i]));
+	
+	job->cycles = -1;
+	if (medir) {
+		counters_stop(&set, &valores);
+		job->cycles = valores.values[COUNTER_CYCLES];
+	}
 }
 
-void test_mult() {
+/*
+ * Verifica una variante con un producto conocido
+ * de 3 x 4 por 4 x 2.
+ */
+static bool test_mult(const bench_variant_t *variant) {
+	static const int val_a[3][4] = {{3, 5, 8, 4}, {2, 1, 0, 2}, {3, 5, 7, 2}};
+	static const int val_b[4][2] = {{1, 2}, {7, 3}, {2, 1}, {4, 3}};
+	static const int val_c[3][2] = {{70, 41}, {17, 13}, {60, 34}};
 	matrix_t *a, *b, *c;
+	bool ok = true;
+	int i, j;
 	
-	printf("\ntest_mult\n");
-	    
-    // Create matrices A, B, C
 	matrix_create(&a, 3, 4);
-    matrix_create(&b, 4, 2);
-    matrix_create(&c, 3, 2);
-    
-    // Fill matrix A
-    matrix_ref(a, 0, 0) = 3;
-    matrix_ref(a, 0, 1) = 5;
-    matrix_ref(a, 0, 2) = 8;
-	matrix_ref(a, 0, 3) = 4;
-	matrix_ref(a, 1, 0) = 2;
-	matrix_ref(a, 1, 1) = 1;
-	matrix_ref(a, 1, 2) = 0;
-	matrix_ref(a, 1, 3) = 2;
-	matrix_ref(a, 2, 0) = 3;
-	matrix_ref(a, 2, 1) = 5;
-	matrix_ref(a, 2, 2) = 7;
-	matrix_ref(a, 2, 3) = 2;
-    
-    // Fill matrix B
-    matrix_ref(b, 0, 0) = 1;
-    matrix_ref(b, 0, 1) = 2;
-    matrix_ref(b, 1, 0) = 7;
-    matrix_ref(b, 1, 1) = 3;
-    matrix_ref(b, 2, 0) = 2;
-    matrix_ref(b, 2, 1) = 1;
-    matrix_ref(b, 3, 0) = 4;
-    matrix_ref(b, 3, 1) = 3;
-    
-    // Print matrices A, B
-    matrix_print(a, stdout);
-    printf("\n");
-    matrix_print(b, stdout);
-    
-    // Multiply matrices A, B
-    matrix_mult(a, b, c, 0, 0, 0, 1);
-    matrix_mult(a, b, c, 1, 1, 0, 1);
-    matrix_mult(a, b, c, 2, 2, 0, 1);
-    
-    // Print matrix C
-    printf("\n");
-    matrix_print(c, stdout);
-    
-    // Destroy matrices A, B, C
-    matrix_destroy(a);
-    matrix_destroy(b);
-    matrix_destroy(c);
+	matrix_create(&b, 4, 2);
+	matrix_create(&c, 3, 2);
+	
+	for (i=0; i < 3; i++)
+	for (j=0; j < 4; j++)
+		matrix_ref(a, i, j) = val_a[i][j];
+	
+	for (i=0; i < 4; i++)
+	for (j=0; j < 2; j++)
+		matrix_ref(b, i, j) = val_b[i][j];
+	
+	// En dos bloques de filas, como lo harían dos hilos
+	variant->fn(a, b, c, 0, 1, 0, 2);
+	variant->fn(a, b, c, 1, 2, 0, 2);
+	
+	for (i=0; i < 3; i++)
+	for (j=0; j < 2; j++)
+		if (matrix_ref(c, i, j) != val_c[i][j])
+			ok = false;
+	
+	matrix_destroy(a);
+	matrix_destroy(b);
+	matrix_destroy(c);
+	
+	return ok;
 }
 
+/*
+ * Mide una variante sobre una forma con "thread_count"
+ * hilos del pool e imprime una línea de resultados.
+ */
+static void bench_case(pool_t *pool, int thread_count, const bench_shape_t *shape,
+		const bench_variant_t *variant, double max_error, bool counters) {
+	
+	matrix_t **a, **b, **c;
+	bench_job_t *jobs;
+	time_rec_t tiempo = {0};
+	long long inicio, tsc_inicio, tsc_total = 0, ciclos_total = 0;
+	double suma = 0.0, suma_cuad = 0.0, media = 0.0, error = 0.0, fmas, ciclos_fma;
+	const char *fuente;
+	int i, r, reps = 0;
+	
+	a = GET_MEM(matrix_t *, shape->batch);
+	b = GET_MEM(matrix_t *, shape->batch);
+	c = GET_MEM(matrix_t *, shape->batch);
+	jobs = GET_MEM(bench_job_t, thread_count);
+	
+	for (i=0; i < shape->batch; i++) {
+		matrix_create(&a[i], shape->m, shape->k);
+		matrix_create(&b[i], shape->k, shape->n);
+		matrix_create(&c[i], shape->m, shape->n);
+		matrix_fill(a[i]);
+		matrix_fill(b[i]);
+	}
+	
+	/*
+	 * Un lote se reparte por multiplicaciones; una
+	 * multiplicación sola, por bloques de filas.
+	 */
+	for (i=0; i < thread_count; i++) {
+		jobs[i].a        = a;
+		jobs[i].b        = b;
+		jobs[i].c        = c;
+		jobs[i].fn       = variant->fn;
+		jobs[i].counters = counters;
+		
+		if (shape->batch > 1) {
+			jobs[i].batch_begin = (int) ((long) shape->batch * i / thread_count);
+			jobs[i].batch_end   = (int) ((long) shape->batch * (i + 1) / thread_count);
+			jobs[i].row_begin   = 0;
+			jobs[i].row_end     = shape->m;
+		}
+		else {
+			jobs[i].batch_begin = 0;
+			jobs[i].batch_end   = 1;
+			jobs[i].row_begin   = (int) ((long) shape->m * i / thread_count);
+			jobs[i].row_end     = (int) ((long) shape->m * (i + 1) / thread_count);
+		}
+	}
+	
+	if (variant->kernel != NULL)
+		gemm_kernel_set(variant->kernel);
+	
+	/*
+	 * La primera ejecución (descartada) asigna los
+	 * buffers de empaquetado y calienta las cachés.
+	 */
+	inicio = get_time_nanos();
+	for (r=-1; r < BENCH_MAX_REPS; r++) {
+		tsc_inicio = read_tsc();
+		TIME_BEGIN(tiempo);
+		for (i=0; i < thread_count; i++)
+			pool_submit_to(pool, i, bench_job, &jobs[i]);
+		pool_wait(pool);
+		TIME_END(tiempo);
+		
+		if (r < 0)
+			continue;
+		
+		reps++;
+		suma      += TIME_DIFF(tiempo);
+		suma_cuad += DOUBLE(TIME_DIFF(tiempo)) * TIME_DIFF(tiempo);
+		tsc_total += read_tsc() - tsc_inicio;
+		
+		for (i=0; i < thread_count && ciclos_total >= 0; i++)
+			ciclos_total = jobs[i].cycles < 0 ? -1 : ciclos_total + jobs[i].cycles;
+		
+		/*
+		 * Semi-amplitud del intervalo de confianza del
+		 * 95% de la media, relativa a la media.
+		 */
+		media = suma / reps;
+		if (reps >= 2) {
+			double varianza = MAX(0.0, (suma_cuad - reps * media * media) / (reps - 1));
+			error = media > 0.0 ? student_t(reps - 1) * sqrt(varianza / reps) / media : 0.0;
+		}
+		
+		if (reps >= BENCH_MIN_REPS && (error <= max_error ||
+				get_time_nanos() - inicio >= BENCH_MAX_NANOS))
+			break;
+	}
+	
+	/*
+	 * Ciclos por FMA (una multiplicación y una suma),
+	 * sumando los ciclos de todos los hilos: del
+	 * contador de ciclos si está disponible, o si no,
+	 * ciclos de referencia (TSC) por la cantidad de
+	 * hilos, que no siguen cambios de frecuencia.
+	 */
+	fmas = DOUBLE(shape->m) * shape->k * shape->n * shape->batch * reps;
+	if (ciclos_total >= 0 && counters) {
+		ciclos_fma = ciclos_total / fmas;
+		fuente     = "perf";
+	}
+	else if (tsc_total >= 0) {
+		ciclos_fma = DOUBLE(tsc_total) * thread_count / fmas;
+		fuente     = "tsc";
+	}
+	else {
+		ciclos_fma = -1.0;
+		fuente     = "-";
+	}
+	
+	printf("%-10s %4dx%4dx%4d x%-4d %-12s %5d %5d %12.3f %7.2f%% %9.2f ",
+			shape->name, shape->m, shape->k, shape->n, shape->batch, variant->name,
+			thread_count, reps, NANOS_TO_MILLIS(media), 100.0 * error,
+			media > 0.0 ? 2.0 * fmas / reps / media : 0.0);
+	if (ciclos_fma >= 0.0)
+		printf("%10.3f %s\n", ciclos_fma, fuente);
+	else
+		printf("%10s %s\n", "-", fuente);
+	fflush(stdout);
+	
+	for (i=0; i < shape->batch; i++) {
+		matrix_destroy(a[i]);
+		matrix_destroy(b[i]);
+		matrix_destroy(c[i]);
+	}
+	free(a);
+	free(b);
+	free(c);
+	free(jobs);
+}
+
+int main(int argc, char **argv) {
+	const gemm_kernel_t *kernels[GEMM_MAX_KERNELS];
+	bench_variant_t variants[GEMM_MAX_KERNELS + 1];
+	cpu_topology_t topo = {0};
+	counter_set_t set;
+	counters_t prueba;
+	pool_t *pool = NULL;
+	double max_error = BENCH_DEFAULT_ERROR;
+	int thread_count = 1, variant_count = 0, kernel_count, *place;
+	bool counters;
+	int i, s;
+	
+	for (i=1; i < argc; i++) {
+		if (strcmp(argv[i], "-h") == 0 && i + 1 < argc && is_number(argv[i + 1]) &&
+				atoi(argv[i + 1]) > 0)
+			thread_count = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0.0)
+			max_error = atof(argv[++i]);
+		else {
+			fprintf(stderr, "Uso: %s [-h cantidad_hilos] [-e error_relativo]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	
+	matrix_tiles_init(0, 0, 0);
+	gemm_init();
+	
+	/*
+	 * Variantes: cada micro-núcleo que soporta el
+	 * procesador, y la multiplicación por bloques
+	 * sin empaquetado.
+	 */
+	kernel_count = gemm_kernels_available(kernels, GEMM_MAX_KERNELS);
+	for (i=0; i < kernel_count; i++, variant_count++) {
+		snprintf(variants[variant_count].name, sizeof(variants[variant_count].name),
+				"gemm-%s", kernels[i]->name);
+		variants[variant_count].fn     = matrix_mult;
+		variants[variant_count].kernel = kernels[i];
+	}
+	snprintf(variants[variant_count].name, sizeof(variants[variant_count].name), "bloques");
+	variants[variant_count].fn     = matrix_mult_blocked;
+	variants[variant_count].kernel = NULL;
+	variant_count++;
+	
+	for (i=0; i < variant_count; i++) {
+		if (variants[i].kernel != NULL)
+			gemm_kernel_set(variants[i].kernel);
+		if (!test_mult(&variants[i]))
+			LOG(FATAL, "La variante %s calcula un producto incorrecto.", variants[i].name);
+	}
+	
+	/*
+	 * Hilos fijados a procesadores, repartidos
+	 * entre los nodos NUMA.
+	 */
+	pool_create(&pool, thread_count);
+	if (cpu_topology_read(&topo)) {
+		place = GET_MEM(int, thread_count);
+		cpu_topology_place(&topo, thread_count, place);
+		
+		for (i=0; i < thread_count; i++)
+			if (!pool_pin(pool, i, topo.cpus[place[i]].cpu))
+				LOG(WARN, "No se pudo fijar el hilo %d al procesador %d.",
+						i, topo.cpus[place[i]].cpu);
+		
+		free(place);
+		cpu_topology_free(&topo);
+	}
+	else
+		LOG(WARN, "No se pudo leer la topología. Los hilos no se fijarán.");
+	
+	/*
+	 * Contador de ciclos: si no está disponible se
+	 * usan los ciclos de referencia (TSC).
+	 */
+	counters = counters_start(&set);
+	counters_stop(&set, &prueba);
+	counters = counters && prueba.values[COUNTER_CYCLES] >= 0;
+	
+	printf("Tipo de elemento: %s. Tamaños de bloque: kc=%d, mc=%d, nc=%d.\n",
+			MATRIX_ELEM_T_NAME, matrix_tiles_get().kc, matrix_tiles_get().mc,
+			matrix_tiles_get().nc);
+	printf("%-10s %-20s %-12s %5s %5s %12s %8s %9s %10s %s\n", "forma", "m x k x n x lote",
+			"variante", "hilos", "reps", "media (ms)", "IC95", MATRIX_OPS_UNIT,
+			"ciclos/FMA", "fuente");
+	
+	for (s=0; s < BENCH_SHAPE_COUNT; s++)
+	for (i=0; i < variant_count; i++)
+		bench_case(pool, thread_count, &shapes[s], &variants[i], max_error, counters);
+	
+	pool_destroy(pool);
+	gemm_workspace_release();
+	
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,257 @@
+#include "quant.h"
+
+/*
+ * Micro-núcleo cuantizado portable.
+ */
+static void qkernel_scalar(int kp, const int16_t *a, const int16_t *b, int32_t *c) {
+	int32_t ab[QUANT_SCALAR_MR][QUANT_SCALAR_NR] = {{0}};
+	int i, j, p;
+	
+	for (p=0; p < kp; p++) {
+		for (i=0; i < QUANT_SCALAR_MR; i++)
+		for (j=0; j < QUANT_SCALAR_NR; j++)
+			ab[i][j] += (int32_t) a[2 * i] * b[2 * j] + 
+						(int32_t) a[2 * i + 1] * b[2 * j + 1];
+		
+		a += 2 * QUANT_SCALAR_MR;
+		b += 2 * QUANT_SCALAR_NR;
+	}
+	
+	memcpy(c, ab, sizeof(ab));
+}
+
+static const quant_kernel_t qkernel_scalar_desc = {
+	"escalar", QUANT_SCALAR_MR, QUANT_SCALAR_NR, qkernel_scalar
+};
+
+/*
+ * Estado de la cuantización.
+ */
+static int bits = 0;
+static const quant_kernel_t *qkernel = &qkernel_scalar_desc;
+
+void quant_init(int quant_bits) {
+	cpu_features_t features;
+	
+	if (quant_bits != 8 && quant_bits != 16)
+		LOG(FATAL, "%s(): %s", __func__, "Los elementos cuantizados deben ser de 8 o 16 bits.");
+	
+	bits = quant_bits;
+	qkernel = &qkernel_scalar_desc;
+	cpu_features_read(&features);
+	
+#ifdef GEMM_X86
+	if (features.avx512bw)
+		qkernel = &quant_kernel_avx512;
+	else if (features.avx2)
+		qkernel = &quant_kernel_avx2;
+#endif
+}
+
+int quant_bits(void) {
+	return bits;
+}
+
+const quant_kernel_t *quant_kernel_get(void) {
+	return qkernel;
+}
+
+void qmatrix_create(qmatrix_t **qmat, int bits, int nrows, int ncols) {
+	int elem = bits / 8;
+	int line_elems = CACHE_LINE_SIZE / elem;
+	size_t size;
+	
+	if (nrows <= 0 || ncols <= 0)
+		LOG(FATAL, "%s(): %s", __func__, "El número de filas y/o columnas debe ser positivo.");
+	
+	(*qmat) = GET_MEM(qmatrix_t, 1);
+	(*qmat)->rows = nrows;
+	(*qmat)->cols = ncols;
+	(*qmat)->bits = bits;
+	(*qmat)->ld   = (ncols + line_elems - 1) / line_elems * line_elems;
+	
+	size = (size_t) nrows * (*qmat)->ld * elem;
+	(*qmat)->elements = xmalloc_aligned(CACHE_LINE_SIZE, size);
+	memset((*qmat)->elements, 0, size);
+}
+
+void qmatrix_destroy(qmatrix_t *qmat) {
+	free(qmat->elements);
+	free(qmat);
+}
+
+/*
+ * Obtiene el elemento (row, col) de una
+ * matriz cuantizada, extendido a 16 bits.
+ */
+static inline int16_t qmatrix_val(const qmatrix_t *qmat, int row, int col) {
+	size_t pos = (size_t) row * qmat->ld + col;
+	
+	if (qmat->bits == 8)
+		return ((const int8_t *) qmat->elements)[pos];
+	
+	return ((const int16_t *) qmat->elements)[pos];
+}
+
+long qmatrix_from_matrix(qmatrix_t *qmat, matrix_t *mat) {
+	double max = qmat->bits == 8 ? INT8_MAX : INT16_MAX;
+	double min = qmat->bits == 8 ? INT8_MIN : INT16_MIN;
+	double valor;
+	long saturados = 0;
+	int i, j;
+	
+	for (i=0; i < matrix_rows(mat); i++)
+	for (j=0; j < matrix_cols(mat); j++) {
+		valor = round((double) matrix_val(mat, i, j));
+		
+		if (valor > max || valor < min) {
+			valor = valor > max ? max : min;
+			++saturados;
+		}
+		
+		size_t pos = (size_t) i * qmat->ld + j;
+		if (qmat->bits == 8)
+			((int8_t *) qmat->elements)[pos] = (int8_t) valor;
+		else
+			((int16_t *) qmat->elements)[pos] = (int16_t) valor;
+	}
+	
+	return saturados;
+}
+
+/*
+ * Empaqueta el bloque de mc x kc de A que comienza
+ * en (row, col) en paneles de mr filas, como pares
+ * de elementos consecutivos en k. Las filas y el
+ * último elemento de k faltantes se completan
+ * con ceros.
+ */
+static void qpack_a(qmatrix_t *a, int row, int col, int mc, int kc, int mr,
+		int16_t *dest) {
+	
+	int ir, i, k, rows;
+	
+	for (ir=0; ir < mc; ir += mr) {
+		rows = MIN(mr, mc - ir);
+		
+		for (k=0; k < kc; k += 2) {
+			for (i=0; i < rows; i++) {
+				dest[2 * i]     = qmatrix_val(a, row + ir + i, col + k);
+				dest[2 * i + 1] = k + 1 < kc ? qmatrix_val(a, row + ir + i, col + k + 1) : 0;
+			}
+			for (; i < mr; i++)
+				dest[2 * i] = dest[2 * i + 1] = 0;
+			
+			dest += 2 * mr;
+		}
+	}
+}
+
+/*
+ * Empaqueta el bloque de kc x nc de B que comienza
+ * en (row, col) en paneles de nr columnas, como pares
+ * de elementos consecutivos en k (intercalando dos
+ * filas). Las columnas y la última fila faltantes se
+ * completan con ceros.
+ */
+static void qpack_b(qmatrix_t *b, int row, int col, int kc, int nc, int nr,
+		int16_t *dest) {
+	
+	int jr, j, k, cols;
+	
+	for (jr=0; jr < nc; jr += nr) {
+		cols = MIN(nr, nc - jr);
+		
+		for (k=0; k < kc; k += 2) {
+			for (j=0; j < cols; j++) {
+				dest[2 * j]     = qmatrix_val(b, row + k, col + jr + j);
+				dest[2 * j + 1] = k + 1 < kc ? qmatrix_val(b, row + k + 1, col + jr + j) : 0;
+			}
+			for (; j < nr; j++)
+				dest[2 * j] = dest[2 * j + 1] = 0;
+			
+			dest += 2 * nr;
+		}
+	}
+}
+
+/*
+ * Recorre el bloque de mc x nc de C que comienza en
+ * (row, col) invocando al micro-núcleo por cada
+ * sub-bloque de mr x nr, y suma el resultado a C.
+ */
+static void qmacro_kernel(const int16_t *pack_a, const int16_t *pack_b,
+		matrix_t *c, int row, int col, int mc, int nc, int kc) {
+	
+	int mr = qkernel->mr, nr = qkernel->nr;
+	int kp = (kc + 1) / 2;
+	int ir, jr, i, j, rows, cols;
+	int32_t tmp[GEMM_MAX_MR * GEMM_MAX_NR] __attribute__((aligned(CACHE_LINE_SIZE)));
+	
+	for (jr=0; jr < nc; jr += nr) {
+		cols = MIN(nr, nc - jr);
+		
+		for (ir=0; ir < mc; ir += mr) {
+			rows = MIN(mr, mc - ir);
+			
+			qkernel->fn(kp, pack_a + (size_t) ir * kp * 2, 
+						pack_b + (size_t) jr * kp * 2, tmp);
+			
+			for (i=0; i < rows; i++) {
+				matrix_elem_t *c_row = matrix_row(c, row + ir + i) + col + jr;
+				
+				for (j=0; j < cols; j++)
+					c_row[j] += tmp[i * nr + j];
+			}
+		}
+	}
+}
+
+void qmatrix_mult(qmatrix_t *a, qmatrix_t *b, matrix_t *c,
+		int row_begin, int row_count, int col_begin, int col_count) {
+	
+	matrix_tiles_t t = matrix_tiles_get();
+	int mr = qkernel->mr, nr = qkernel->nr;
+	int ic, jc, pc, mc, nc, kc, kp;
+	int row_end = row_begin + row_count;
+	int col_end = col_begin + col_count;
+	int k_end   = a->cols;
+	int16_t *buf_a, *buf_b;
+	
+	if (a->cols != b->rows)
+		LOG(FATAL, "%s(): %s %s", __func__, 
+				"El número de columnas de la matriz A debe ser igual a",
+				"el númbero de filas de la matriz B");
+	
+	if (row_count <= 0 || col_count <= 0)
+		return;
+	
+	/*
+	 * Los bloques de k deben tener una cantidad
+	 * par de elementos (salvo el último).
+	 */
+	t.kc += t.kc % 2;
+	
+	mc = MIN(t.mc, row_count);
+	nc = MIN(t.nc, col_count);
+	kp = (MIN(t.kc, k_end) + 1) / 2;
+	gemm_workspace_get((size_t) (mc + mr - 1) / mr * mr * kp * 2 * sizeof(int16_t),
+					   (size_t) (nc + nr - 1) / nr * nr * kp * 2 * sizeof(int16_t),
+					   (void **) &buf_a, (void **) &buf_b);
+	
+	for (jc=col_begin; jc < col_end; jc += t.nc) {
+		nc = MIN(t.nc, col_end - jc);
+		
+		for (pc=0; pc < k_end; pc += t.kc) {
+			kc = MIN(t.kc, k_end - pc);
+			qpack_b(b, pc, jc, kc, nc, nr, buf_b);
+			
+			for (ic=row_begin; ic < row_end; ic += t.mc) {
+				mc = MIN(t.mc, row_end - ic);
+				qpack_a(a, ic, pc, mc, kc, mr, buf_a);
+				
+				qmacro_kernel(buf_a, buf_b, c, ic, jc, mc, nc, kc);
+			}
+		}
+	}
+}
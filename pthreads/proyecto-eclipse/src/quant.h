@@ -0,0 +1,107 @@
+#ifndef QUANT_H_
+#define QUANT_H_
+
+#include <stdint.h>
+
+#include "gemm.h"
+
+/*
+ * Dimensiones del micro-núcleo cuantizado portable.
+ */
+#define QUANT_SCALAR_MR 4
+#define QUANT_SCALAR_NR 8
+
+/*
+ * Matriz cuantizada: sus elementos se almacenan
+ * como enteros con signo de 8 o 16 bits, por filas
+ * en un bloque contiguo alineado, igual que en
+ * matrix_t.
+ */
+struct qmatrix {
+	void *elements;
+	int rows;
+	int cols;
+	int ld;
+	int bits;
+};
+
+/*
+ * Función de micro-núcleo cuantizado. Los paneles
+ * empaquetados contienen pares de elementos consecutivos
+ * en k, extendidos a 16 bits: para cada par p, el panel
+ * de A guarda (a[i][2p], a[i][2p+1]) para sus MR filas y
+ * el de B guarda (b[2p][j], b[2p+1][j]) para sus NR
+ * columnas. Cada par se multiplica y suma en una sola
+ * operación (vpmaddwd), acumulando en 32 bits. El
+ * resultado se almacena (no se acumula) en el bloque
+ * contiguo de MR x NR enteros apuntado por "c".
+ */
+typedef void (*quant_ukernel_fn)(int kp, const int16_t *a,
+		const int16_t *b, int32_t *c);
+
+/*
+ * Descriptor de un micro-núcleo cuantizado.
+ */
+typedef struct {
+	const char *name;
+	int mr;
+	int nr;
+	quant_ukernel_fn fn;
+} quant_kernel_t;
+
+/*
+ * Micro-núcleos vectoriales (ver gemm_avx2.c y
+ * gemm_avx512.c), compilados solo en x86.
+ */
+#ifdef GEMM_X86
+extern const quant_kernel_t quant_kernel_avx2;
+extern const quant_kernel_t quant_kernel_avx512;
+#endif
+
+/*
+ * Habilita la multiplicación cuantizada con elementos
+ * de "bits" bits (8 o 16) y selecciona el micro-núcleo
+ * según las extensiones SIMD detectadas.
+ */
+void quant_init(int bits);
+
+/*
+ * Retorna la cantidad de bits de los elementos
+ * cuantizados, o cero si la cuantización no está
+ * habilitada.
+ */
+int quant_bits(void);
+
+/*
+ * Retorna el micro-núcleo cuantizado seleccionado.
+ */
+const quant_kernel_t *quant_kernel_get(void);
+
+/*
+ * Crea una matriz cuantizada de nrows x ncols
+ * con elementos de "bits" bits.
+ */
+void qmatrix_create(qmatrix_t **qmat, int bits, int nrows, int ncols);
+
+/*
+ * Destruye una matriz cuantizada.
+ */
+void qmatrix_destroy(qmatrix_t *qmat);
+
+/*
+ * Carga una matriz cuantizada con los valores de
+ * "mat", redondeados y saturados al rango del tipo.
+ * Retorna la cantidad de elementos saturados.
+ */
+long qmatrix_from_matrix(qmatrix_t *qmat, matrix_t *mat);
+
+/*
+ * Multiplicación cuantizada. Misma semántica que
+ * matrix_mult(): acumula en C el bloque de filas
+ * [row_begin, row_begin + row_count) y columnas
+ * [col_begin, col_begin + col_count) de A x B.
+ */
+void qmatrix_mult(qmatrix_t *a, qmatrix_t *b, matrix_t *c,
+		int row_begin, int row_count, int col_begin, int col_count);
+
+#endif /*QUANT_H_*/
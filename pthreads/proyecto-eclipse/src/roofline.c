@@ -0,0 +1,230 @@
+#include "roofline.h"
+
+/*
+ * Porción de los arreglos de la triada de STREAM
+ * que procesa un hilo.
+ */
+typedef struct {
+	matrix_elem_t *a;
+	const matrix_elem_t *b;
+	const matrix_elem_t *c;
+	long begin;
+	long end;
+	bool init;		// Inicializar (primer acceso) en lugar de medir
+} triad_args;
+
+/*
+ * Trabajo de la triada: a[i] = b[i] + s * c[i].
+ */
+static void triad_thread(void *args) {
+	triad_args *aux = (triad_args *) args;
+	matrix_elem_t *a = aux->a;
+	long i;
+	
+	if (aux->init) {
+		for (i=aux->begin; i < aux->end; i++) {
+			a[i] = 0;
+			((matrix_elem_t *) aux->b)[i] = 1;
+			((matrix_elem_t *) aux->c)[i] = 2;
+		}
+		return;
+	}
+	
+	for (i=aux->begin; i < aux->end; i++)
+		a[i] = aux->b[i] + 3 * aux->c[i];
+}
+
+/*
+ * Mide el ancho de banda de memoria (en bytes por
+ * nanosegundo, es decir, GB/s) con la triada de
+ * STREAM, repartida entre "cpu_count" hilos. Se
+ * cuentan dos lecturas y una escritura por elemento.
+ */
+static double measure_bandwidth(int cpu_count) {
+	matrix_elem_t *a, *b, *c;
+	triad_args *args;
+	cache_info_t cache;
+	pool_t *pool;
+	time_rec_t tiempo = {0};
+	long bytes = ROOFLINE_STREAM_BYTES, n;
+	double mejor = 0.0;
+	int i, r;
+	
+	if (cache_info_read(&cache) && 4 * cache.l3 > bytes)
+		bytes = 4 * cache.l3;
+	n = bytes / sizeof(matrix_elem_t);
+	
+	a = GET_MEM_ALIGNED(matrix_elem_t, n);
+	b = GET_MEM_ALIGNED(matrix_elem_t, n);
+	c = GET_MEM_ALIGNED(matrix_elem_t, n);
+	args = GET_MEM(triad_args, cpu_count);
+	
+	pool_create(&pool, cpu_count);
+	
+	for (i=0; i < cpu_count; i++) {
+		args[i].a     = a;
+		args[i].b     = b;
+		args[i].c     = c;
+		args[i].begin = n * i / cpu_count;
+		args[i].end   = n * (i + 1) / cpu_count;
+	}
+	
+	/*
+	 * Cada hilo inicializa su porción y luego se
+	 * toma la mejor de ROOFLINE_REPS pasadas.
+	 */
+	for (r=-1; r < ROOFLINE_REPS; r++) {
+		for (i=0; i < cpu_count; i++)
+			args[i].init = r < 0;
+		
+		TIME_BEGIN(tiempo);
+		for (i=0; i < cpu_count; i++)
+			pool_submit(pool, triad_thread, &args[i]);
+		pool_wait(pool);
+		TIME_END(tiempo);
+		
+		if (r >= 0 && TIME_DIFF(tiempo) > 0)
+			mejor = MAX(mejor, 3.0 * bytes / TIME_DIFF(tiempo));
+	}
+	
+	pool_destroy(pool);
+	free(args);
+	free(a);
+	free(b);
+	free(c);
+	
+	return mejor;
+}
+
+/*
+ * Mide las operaciones por nanosegundo de un núcleo
+ * ejecutando el micro-núcleo seleccionado sobre
+ * paneles que caben en L1: una cadena de FMA (o
+ * multiplicaciones y sumas) con mr x nr acumuladores
+ * independientes en registros.
+ */
+static double measure_peak(void) {
+	const gemm_kernel_t *kernel = gemm_kernel_get();
+	int kc = ROOFLINE_PEAK_KC;
+	matrix_elem_t *a, *b, *c;
+	time_rec_t tiempo = {0};
+	double ops, mejor = 0.0;
+	long llamadas, j;
+	int i, r;
+	
+	a = GET_MEM_ALIGNED(matrix_elem_t, kc * kernel->mr);
+	b = GET_MEM_ALIGNED(matrix_elem_t, kc * kernel->nr);
+	c = GET_MEM_ALIGNED(matrix_elem_t, kernel->mr * kernel->nr);
+	
+	for (i=0; i < kc * kernel->mr; i++)
+		a[i] = 1;
+	for (i=0; i < kc * kernel->nr; i++)
+		b[i] = 0;
+	memset(c, 0, kernel->mr * kernel->nr * sizeof(matrix_elem_t));
+	
+	/*
+	 * Cantidad de llamadas para unos 20 ms por pasada,
+	 * estimada con una pasada corta.
+	 */
+	llamadas = 1000;
+	TIME_BEGIN(tiempo);
+	for (j=0; j < llamadas; j++)
+		kernel->fn(kc, a, b, c, kernel->nr);
+	TIME_END(tiempo);
+	
+	if (TIME_DIFF(tiempo) > 0)
+		llamadas = MAX(1000, (long) (llamadas * 20e6 / TIME_DIFF(tiempo)));
+	
+	ops = 2.0 * kernel->mr * kernel->nr * kc * llamadas;
+	
+	for (r=0; r < ROOFLINE_REPS; r++) {
+		TIME_BEGIN(tiempo);
+		for (j=0; j < llamadas; j++)
+			kernel->fn(kc, a, b, c, kernel->nr);
+		TIME_END(tiempo);
+		
+		if (TIME_DIFF(tiempo) > 0)
+			mejor = MAX(mejor, ops / TIME_DIFF(tiempo));
+	}
+	
+	free(a);
+	free(b);
+	free(c);
+	
+	return mejor;
+}
+
+/*
+ * Clave de la calibración: equipo, procesador,
+ * tipo de elemento y micro-núcleo.
+ */
+static void roofline_key(char *buf, int size) {
+	char host[64], modelo[128];
+	
+	if (gethostname(host, sizeof(host)) != 0)
+		snprintf(host, sizeof(host), "desconocido");
+	host[sizeof(host) - 1] = '\0';
+	cpu_model_read(modelo, sizeof(modelo));
+	
+	snprintf(buf, size, "%s\t%s\t%s\t%s", host, modelo, MATRIX_ELEM_T_NAME,
+			gemm_kernel_get()->name);
+}
+
+void roofline_get(roofline_t *roof) {
+	FILE *archivo = NULL;
+	char clave[256], linea[512];
+	int len;
+	
+	roofline_key(clave, sizeof(clave));
+	len = strlen(clave);
+	
+	/*
+	 * Cada línea: clave, ancho de banda, pico por
+	 * núcleo y procesadores, separados por tabuladores.
+	 */
+	if ((archivo = fopen(ROOFLINE_FILE, "r")) != NULL) {
+		while (fgets(linea, sizeof(linea), archivo) != NULL) {
+			if (strncmp(linea, clave, len) == 0 && linea[len] == '\t' &&
+					sscanf(linea + len + 1, "%lf\t%lf\t%d", &roof->bandwidth,
+						&roof->peak_core, &roof->cpu_count) == 3) {
+				fclose(archivo);
+				return;
+			}
+		}
+		fclose(archivo);
+	}
+	
+	LOG(INFO, "Calibrando ancho de banda y pico de cómputo (una única vez).");
+	roof->cpu_count = MAX(1, (int) sysconf(_SC_NPROCESSORS_ONLN));
+	roof->bandwidth = measure_bandwidth(roof->cpu_count);
+	roof->peak_core = measure_peak();
+	
+	if ((archivo = fopen(ROOFLINE_FILE, "a")) == NULL) {
+		LOG(WARN, "Error al abrir archivo de calibración \"%s\". %s",
+				ROOFLINE_FILE, "La calibración no se guardará.");
+		return;
+	}
+	
+	fprintf(archivo, "%s\t%f\t%f\t%d\n", clave, roof->bandwidth, roof->peak_core,
+			roof->cpu_count);
+	fclose(archivo);
+}
+
+double roofline_traffic(int m, int k, int n) {
+	matrix_tiles_t tiles = matrix_tiles_get();
+	double bloques_n = (n + tiles.nc - 1) / tiles.nc;
+	double bloques_k = (k + tiles.kc - 1) / tiles.kc;
+	
+	return sizeof(matrix_elem_t) * (DOUBLE(m) * k * bloques_n + DOUBLE(k) * n +
+			2.0 * m * n * bloques_k);
+}
+
+void roofline_place(const roofline_t *roof, double ops, double bytes, double nanos,
+		int threads, roofline_point_t *point) {
+	
+	point->intensity    = bytes > 0.0 ? ops / bytes : 0.0;
+	point->peak         = roof->peak_core * MIN(MAX(threads, 1), roof->cpu_count);
+	point->attainable   = MIN(point->peak, point->intensity * roof->bandwidth);
+	point->achieved     = nanos > 0.0 ? ops / nanos : 0.0;
+	point->memory_bound = point->intensity * roof->bandwidth < point->peak;
+}
@@ -0,0 +1,87 @@
+#ifndef ROOFLINE_H_
+#define ROOFLINE_H_
+
+#include "gemm.h"
+#include "pool.h"
+
+/*
+ * Nombre del archivo en el que se guardan los
+ * resultados de la calibración de cada equipo.
+ */
+#define ROOFLINE_FILE "matrix-mult_roofline.csv"
+
+/*
+ * Tamaño mínimo (en bytes) de cada arreglo de la
+ * prueba de ancho de banda. Se usa al menos cuatro
+ * veces la caché L3, para medir la memoria principal.
+ */
+#define ROOFLINE_STREAM_BYTES (64L << 20)
+
+/*
+ * Profundidad de los paneles de la prueba de
+ * cómputo, que deben caber en L1.
+ */
+#define ROOFLINE_PEAK_KC 128
+
+/*
+ * Repeticiones de cada prueba (se toma la mejor).
+ */
+#define ROOFLINE_REPS 5
+
+/*
+ * Techos del modelo "roofline" del equipo:
+ *   bandwidth: ancho de banda de memoria con todos los
+ *              procesadores (triada de STREAM), en GB/s.
+ *   peak_core: operaciones por segundo (en miles de
+ *              millones) de un núcleo, ejecutando el
+ *              micro-núcleo seleccionado sobre datos en L1.
+ */
+typedef struct {
+	double bandwidth;
+	double peak_core;
+	int cpu_count;
+} roofline_t;
+
+/*
+ * Ubicación de una ejecución en el modelo:
+ *   intensity:  intensidad aritmética (operaciones por byte).
+ *   peak:       techo de cómputo para los hilos usados.
+ *   attainable: rendimiento alcanzable, el mínimo entre el
+ *               techo de cómputo y intensity * bandwidth.
+ *   achieved:   rendimiento obtenido.
+ */
+typedef struct {
+	double intensity;
+	double peak;
+	double attainable;
+	double achieved;
+	bool memory_bound;
+} roofline_point_t;
+
+/*
+ * Obtiene los techos del equipo: los lee de
+ * ROOFLINE_FILE o, si no están (o cambió el equipo
+ * o el micro-núcleo), los mide y los guarda.
+ * Debe llamarse luego de gemm_init().
+ */
+void roofline_get(roofline_t *roof);
+
+/*
+ * Estima los bytes transferidos desde memoria por
+ * la multiplicación por bloques de C = A x B (A de
+ * m x k, B de k x n): A se lee una vez por cada
+ * bloque de nc columnas, B una vez, y C se lee y
+ * escribe una vez por cada bloque de kc de la
+ * dimensión común.
+ */
+double roofline_traffic(int m, int k, int n);
+
+/*
+ * Ubica una ejecución de "ops" operaciones y "bytes"
+ * bytes, que tardó "nanos" nanosegundos con "threads"
+ * hilos (0 es secuencial).
+ */
+void roofline_place(const roofline_t *roof, double ops, double bytes, double nanos,
+		int threads, roofline_point_t *point);
+
+#endif /*ROOFLINE_H_*/
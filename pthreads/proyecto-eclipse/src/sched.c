@@ -0,0 +1,123 @@
+#include "sched.h"
+
+/*
+ * Toma el último bloque de la cola de su dueño.
+ * Retorna -1 si la cola está vacía.
+ */
+static int deque_pop(sched_deque_t *deque) {
+	int tile = -1;
+	
+	pthread_mutex_lock(&deque->mutex);
+	if (deque->bottom > deque->top)
+		tile = --deque->bottom;
+	pthread_mutex_unlock(&deque->mutex);
+	
+	return tile;
+}
+
+/*
+ * Roba el primer bloque de la cola de otro hilo.
+ * Retorna -1 si la cola está vacía.
+ */
+static int deque_steal(sched_deque_t *deque) {
+	int tile = -1;
+	
+	pthread_mutex_lock(&deque->mutex);
+	if (deque->bottom > deque->top)
+		tile = deque->top++;
+	pthread_mutex_unlock(&deque->mutex);
+	
+	return tile;
+}
+
+void sched_create(sched_t **sched, int rows, int cols, int worker_count) {
+	int target = SCHED_TILES_PER_WORKER * worker_count;
+	int grid_rows, grid_cols, tile_rows, tile_cols;
+	int i, j, k;
+	
+	if (worker_count <= 0)
+		LOG(FATAL, "%s(): %s", __func__, "La cantidad de hilos debe ser positiva.");
+	
+	/*
+	 * Grilla de bloques con aproximadamente "target"
+	 * bloques, proporcional a la forma de C.
+	 */
+	grid_rows = (int) (sqrt(target * DOUBLE(rows) / cols) + 0.5);
+	grid_rows = MAX(1, grid_rows);
+	grid_cols = MAX(1, (target + grid_rows - 1) / grid_rows);
+	
+	tile_rows = MAX(SCHED_MIN_TILE_ROWS, (rows + grid_rows - 1) / grid_rows);
+	tile_cols = MAX(SCHED_MIN_TILE_COLS, (cols + grid_cols - 1) / grid_cols);
+	grid_rows = (rows + tile_rows - 1) / tile_rows;
+	grid_cols = (cols + tile_cols - 1) / tile_cols;
+	
+	(*sched) = GET_MEM(sched_t, 1);
+	(*sched)->tile_count   = grid_rows * grid_cols;
+	(*sched)->worker_count = worker_count;
+	(*sched)->tiles        = GET_MEM(sched_tile_t, (*sched)->tile_count);
+	(*sched)->executed_by  = GET_MEM(int, (*sched)->tile_count);
+	(*sched)->stolen       = GET_MEM(bool, (*sched)->tile_count);
+	(*sched)->deques       = GET_MEM(sched_deque_t, worker_count);
+	
+	// Bloques en orden de filas
+	k = 0;
+	for (i=0; i < grid_rows; i++)
+	for (j=0; j < grid_cols; j++) {
+		(*sched)->tiles[k].row_begin = i * tile_rows;
+		(*sched)->tiles[k].row_count = MIN(tile_rows, rows - i * tile_rows);
+		(*sched)->tiles[k].col_begin = j * tile_cols;
+		(*sched)->tiles[k].col_count = MIN(tile_cols, cols - j * tile_cols);
+		(*sched)->executed_by[k] = -1;
+		(*sched)->stolen[k]      = false;
+		++k;
+	}
+	
+	// Cada cola recibe un rango contiguo de bloques
+	for (i=0; i < worker_count; i++) {
+		pthread_mutex_init(&(*sched)->deques[i].mutex, NULL);
+		(*sched)->deques[i].top    = (int) ((long) i * k / worker_count);
+		(*sched)->deques[i].bottom = (int) ((long) (i + 1) * k / worker_count);
+	}
+}
+
+void sched_destroy(sched_t *sched) {
+	int i;
+	
+	for (i=0; i < sched->worker_count; i++)
+		pthread_mutex_destroy(&sched->deques[i].mutex);
+	
+	free(sched->tiles);
+	free(sched->executed_by);
+	free(sched->stolen);
+	free(sched->deques);
+	free(sched);
+}
+
+void sched_run(sched_t *sched, int worker, sched_tile_fn fn, void *arg) {
+	int tile, i;
+	bool stolen;
+	
+	for (;;) {
+		stolen = false;
+		tile   = deque_pop(&sched->deques[worker]);
+		
+		/*
+		 * Cola propia vacía: recorremos las demás
+		 * colas a partir del hilo siguiente. Como no
+		 * se generan bloques nuevos, si todas están
+		 * vacías el trabajo terminó.
+		 */
+		for (i=1; tile < 0 && i < sched->worker_count; i++) {
+			tile   = deque_steal(&sched->deques[(worker + i) % sched->worker_count]);
+			stolen = true;
+		}
+		
+		if (tile < 0)
+			break;
+		
+		fn(arg, &sched->tiles[tile]);
+		
+		sched->executed_by[tile] = worker;
+		sched->stolen[tile]      = stolen;
+	}
+}
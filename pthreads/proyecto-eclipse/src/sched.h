@@ -0,0 +1,82 @@
+#ifndef SCHED_H_
+#define SCHED_H_
+
+#include "matrix.h"
+
+/*
+ * Cantidad de bloques por hilo que se busca
+ * generar al dividir la matriz C.
+ */
+#define SCHED_TILES_PER_WORKER 8
+
+/*
+ * Tamaño mínimo de un bloque de C, para que
+ * el empaquetado de cada bloque se amortice.
+ */
+#define SCHED_MIN_TILE_ROWS 16
+#define SCHED_MIN_TILE_COLS 64
+
+/*
+ * Bloque de la matriz C.
+ */
+typedef struct {
+	int row_begin;
+	int row_count;
+	int col_begin;
+	int col_count;
+} sched_tile_t;
+
+/*
+ * Cola doble de bloques de un hilo. El dueño toma
+ * bloques del final (bottom) y los demás hilos los
+ * roban del principio (top).
+ */
+typedef struct {
+	pthread_mutex_t mutex;
+	int top;
+	int bottom;
+} sched_deque_t;
+
+/*
+ * Planificador dinámico con robo de trabajo.
+ * Las colas contienen rangos contiguos de índices
+ * de bloques, de modo que cada hilo comienza con
+ * bloques vecinos.
+ */
+struct sched {
+	sched_tile_t *tiles;
+	int tile_count;
+	
+	sched_deque_t *deques;
+	int worker_count;
+	
+	int *executed_by;		// Hilo que ejecutó cada bloque
+	bool *stolen;			// Si el bloque fue robado
+};
+
+/*
+ * Función que procesa un bloque de C.
+ */
+typedef void (*sched_tile_fn)(void *arg, const sched_tile_t *tile);
+
+/*
+ * Crea un planificador que divide una matriz de
+ * rows x cols en bloques, y los reparte en partes
+ * iguales entre las colas de "worker_count" hilos.
+ */
+void sched_create(sched_t **sched, int rows, int cols, int worker_count);
+
+/*
+ * Destruye un planificador.
+ */
+void sched_destroy(sched_t *sched);
+
+/*
+ * Ciclo de trabajo del hilo "worker": procesa los
+ * bloques de su cola y, cuando ésta se vacía, roba
+ * bloques de las colas de los demás hilos. Retorna
+ * cuando no quedan bloques en ninguna cola.
+ */
+void sched_run(sched_t *sched, int worker, sched_tile_fn fn, void *arg);
+
+#endif /*SCHED_H_*/
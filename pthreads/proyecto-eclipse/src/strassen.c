@@ -0,0 +1,555 @@
+#include "strassen.h"
+
+/*
+ * Trabajo de una fase de la multiplicación: sumas
+ * previas o posteriores de una franja, un producto
+ * de Strassen-Winograd, o un producto clásico de
+ * un bloque de C (ver matrix_mult()).
+ */
+struct strassen_job {
+	pool_fn fn;
+	strassen_t *st;
+	matrix_t a, b, c;
+	int row_begin, row_count;
+	int col_begin, col_count;
+	bool clear;				// Poner a cero el bloque antes de acumular
+	int levels;
+	matrix_elem_t *ws;
+	int band, band_count;
+};
+
+/*
+ * Dimensión principal de un temporal: las columnas
+ * redondeadas a un múltiplo de una línea de caché.
+ */
+static int temp_ld(int cols) {
+	int line_elems = CACHE_LINE_SIZE / sizeof(matrix_elem_t);
+	
+	return (cols + line_elems - 1) / line_elems * line_elems;
+}
+
+/*
+ * Vista del bloque de rows x cols de "mat" que
+ * comienza en (row, col). Comparte sus elementos
+ * y su dimensión principal.
+ */
+static matrix_t block(const matrix_t *mat, int row, int col, int rows, int cols) {
+	matrix_t view;
+	
+	view.elements = matrix_row(mat, row) + col;
+	view.rows     = rows;
+	view.cols     = cols;
+	view.ld       = matrix_ld(mat);
+	
+	return view;
+}
+
+/*
+ * Temporal de rows x cols sobre el espacio de
+ * trabajo "elements".
+ */
+static matrix_t temp(matrix_elem_t *elements, int rows, int cols) {
+	matrix_t view;
+	
+	view.elements = elements;
+	view.rows     = rows;
+	view.cols     = cols;
+	view.ld       = temp_ld(cols);
+	
+	return view;
+}
+
+/*
+ * Pone a cero un bloque. A diferencia de matrix_clear(),
+ * no toca el relleno, que en una vista pertenece a los
+ * bloques vecinos.
+ */
+static void block_clear(matrix_t *c) {
+	int i;
+	
+	for (i=0; i < matrix_rows(c); i++)
+		memset(matrix_row(c, i), 0, matrix_cols(c) * sizeof(matrix_elem_t));
+}
+
+/*
+ * R = X + Y y R = X - Y, elemento a elemento (R
+ * puede ser X o Y).
+ */
+static void block_add(matrix_t *r, const matrix_t *x, const matrix_t *y) {
+	matrix_elem_t *fila_r, *fila_x, *fila_y;
+	int i, j;
+	
+	for (i=0; i < matrix_rows(r); i++) {
+		fila_r = matrix_row(r, i);
+		fila_x = matrix_row(x, i);
+		fila_y = matrix_row(y, i);
+		
+		for (j=0; j < matrix_cols(r); j++)
+			fila_r[j] = fila_x[j] + fila_y[j];
+	}
+}
+
+static void block_sub(matrix_t *r, const matrix_t *x, const matrix_t *y) {
+	matrix_elem_t *fila_r, *fila_x, *fila_y;
+	int i, j;
+	
+	for (i=0; i < matrix_rows(r); i++) {
+		fila_r = matrix_row(r, i);
+		fila_x = matrix_row(x, i);
+		fila_y = matrix_row(y, i);
+		
+		for (j=0; j < matrix_cols(r); j++)
+			fila_r[j] = fila_x[j] - fila_y[j];
+	}
+}
+
+/*
+ * Elementos de espacio de trabajo que necesita
+ * winograd() para m x k por k x n con "levels"
+ * niveles: por nivel, X (un cuadrante de A o de C)
+ * e Y (un cuadrante de B).
+ */
+static size_t winograd_size(int m, int k, int n, int levels) {
+	if (levels == 0)
+		return 0;
+	
+	m /= 2;
+	k /= 2;
+	n /= 2;
+	
+	return (size_t) m * MAX(temp_ld(k), temp_ld(n)) + (size_t) k * temp_ld(n) +
+			winograd_size(m, k, n, levels - 1);
+}
+
+/*
+ * C = A x B con Strassen-Winograd secuencial, con
+ * "levels" niveles (las dimensiones deben ser
+ * múltiplo de 2^levels). Usa dos temporales por
+ * nivel, X e Y, con el orden de operaciones de
+ * Boyer, Dumas, Pernet y Zhou (2009):
+ *
+ *   S1 = A21 + A22   S2 = S1 - A11   S3 = A11 - A21   S4 = A12 - S2
+ *   T1 = B12 - B11   T2 = B22 - T1   T3 = B22 - B12   T4 = T2 - B21
+ *   M1 = A11 B11   M2 = A12 B21   M3 = S4 B22   M4 = A22 T4
+ *   M5 = S1 T1     M6 = S2 T2     M7 = S3 T3
+ *   C11 = M1 + M2          C12 = M1 + M6 + M5 + M3
+ *   C21 = M1 + M6 + M7 - M4   C22 = M1 + M6 + M7 + M5
+ */
+static void winograd(matrix_t *a, matrix_t *b, matrix_t *c, int levels,
+		matrix_elem_t *ws) {
+	
+	int m2, k2, n2;
+	matrix_t a11, a12, a21, a22, b11, b12, b21, b22, c11, c12, c21, c22;
+	matrix_t xs, xm, y;
+	matrix_elem_t *next;
+	
+	if (levels == 0) {
+		block_clear(c);
+		matrix_mult(a, b, c, 0, matrix_rows(c), 0, matrix_cols(c));
+		return;
+	}
+	
+	m2 = matrix_rows(a) / 2;
+	k2 = matrix_cols(a) / 2;
+	n2 = matrix_cols(b) / 2;
+	
+	a11 = block(a, 0,  0,  m2, k2);
+	a12 = block(a, 0,  k2, m2, k2);
+	a21 = block(a, m2, 0,  m2, k2);
+	a22 = block(a, m2, k2, m2, k2);
+	b11 = block(b, 0,  0,  k2, n2);
+	b12 = block(b, 0,  n2, k2, n2);
+	b21 = block(b, k2, 0,  k2, n2);
+	b22 = block(b, k2, n2, k2, n2);
+	c11 = block(c, 0,  0,  m2, n2);
+	c12 = block(c, 0,  n2, m2, n2);
+	c21 = block(c, m2, 0,  m2, n2);
+	c22 = block(c, m2, n2, m2, n2);
+	
+	// X guarda una S (m2 x k2) o M1 (m2 x n2)
+	xs   = temp(ws, m2, k2);
+	xm   = temp(ws, m2, n2);
+	ws  += (size_t) m2 * MAX(temp_ld(k2), temp_ld(n2));
+	y    = temp(ws, k2, n2);
+	next = ws + (size_t) k2 * temp_ld(n2);
+	
+	block_sub(&xs, &a11, &a21);				// X = S3
+	block_sub(&y, &b22, &b12);				// Y = T3
+	winograd(&xs, &y, &c21, levels - 1, next);		// C21 = M7
+	block_add(&xs, &a21, &a22);				// X = S1
+	block_sub(&y, &b12, &b11);				// Y = T1
+	winograd(&xs, &y, &c22, levels - 1, next);		// C22 = M5
+	block_sub(&xs, &xs, &a11);				// X = S2
+	block_sub(&y, &b22, &y);				// Y = T2
+	winograd(&xs, &y, &c12, levels - 1, next);		// C12 = M6
+	block_sub(&xs, &a12, &xs);				// X = S4
+	winograd(&xs, &b22, &c11, levels - 1, next);	// C11 = M3
+	winograd(&a11, &b11, &xm, levels - 1, next);	// X = M1
+	block_add(&c12, &xm, &c12);				// C12 = M1 + M6
+	block_add(&c21, &c12, &c21);			// C21 = M1 + M6 + M7
+	block_add(&c12, &c12, &c22);			// C12 = M1 + M6 + M5
+	block_add(&c22, &c21, &c22);			// C22 = M1 + M6 + M7 + M5
+	block_add(&c12, &c12, &c11);			// C12 = M1 + M6 + M5 + M3
+	block_sub(&y, &y, &b21);				// Y = T4
+	winograd(&a22, &y, &c11, levels - 1, next);		// C11 = M4
+	block_sub(&c21, &c21, &c11);			// C21 = M1 + M6 + M7 - M4
+	winograd(&a12, &b21, &c11, levels - 1, next);	// C11 = M2
+	block_add(&c11, &xm, &c11);				// C11 = M1 + M2
+}
+
+/*
+ * Sumas previas del primer nivel, sobre una franja
+ * de filas de los cuadrantes de A y de B.
+ */
+static void pre_add_job(void *args) {
+	strassen_job_t *job = (strassen_job_t *) args;
+	strassen_t *st = job->st;
+	matrix_elem_t x11, x12, x21, x22, s1, s2, t1, t2;
+	int rows, cols, begin, end, i, j;
+	
+	rows  = matrix_rows(&st->a[0]);
+	cols  = matrix_cols(&st->a[0]);
+	begin = (int) ((long) rows * job->band / job->band_count);
+	end   = (int) ((long) rows * (job->band + 1) / job->band_count);
+	
+	for (i=begin; i < end; i++)
+	for (j=0; j < cols; j++) {
+		x11 = matrix_val(&st->a[0], i, j);
+		x12 = matrix_val(&st->a[1], i, j);
+		x21 = matrix_val(&st->a[2], i, j);
+		x22 = matrix_val(&st->a[3], i, j);
+		
+		s1 = x21 + x22;
+		s2 = s1 - x11;
+		matrix_ref(&st->s[0], i, j) = s1;
+		matrix_ref(&st->s[1], i, j) = s2;
+		matrix_ref(&st->s[2], i, j) = x11 - x21;
+		matrix_ref(&st->s[3], i, j) = x12 - s2;
+	}
+	
+	rows  = matrix_rows(&st->b[0]);
+	cols  = matrix_cols(&st->b[0]);
+	begin = (int) ((long) rows * job->band / job->band_count);
+	end   = (int) ((long) rows * (job->band + 1) / job->band_count);
+	
+	for (i=begin; i < end; i++)
+	for (j=0; j < cols; j++) {
+		x11 = matrix_val(&st->b[0], i, j);
+		x12 = matrix_val(&st->b[1], i, j);
+		x21 = matrix_val(&st->b[2], i, j);
+		x22 = matrix_val(&st->b[3], i, j);
+		
+		t1 = x12 - x11;
+		t2 = x22 - t1;
+		matrix_ref(&st->t[0], i, j) = t1;
+		matrix_ref(&st->t[1], i, j) = t2;
+		matrix_ref(&st->t[2], i, j) = x22 - x12;
+		matrix_ref(&st->t[3], i, j) = t2 - x21;
+	}
+}
+
+/*
+ * Sumas posteriores del primer nivel, sobre una
+ * franja de filas de los cuadrantes de C (que
+ * guardan M4..M7 y reciben el resultado).
+ */
+static void post_add_job(void *args) {
+	strassen_job_t *job = (strassen_job_t *) args;
+	strassen_t *st = job->st;
+	matrix_elem_t m1, m2, m3, m4, m5, m6, m7, u2, u3;
+	int rows, cols, begin, end, i, j;
+	
+	rows  = matrix_rows(&st->c[0]);
+	cols  = matrix_cols(&st->c[0]);
+	begin = (int) ((long) rows * job->band / job->band_count);
+	end   = (int) ((long) rows * (job->band + 1) / job->band_count);
+	
+	for (i=begin; i < end; i++)
+	for (j=0; j < cols; j++) {
+		m1 = matrix_val(&st->p[0], i, j);
+		m2 = matrix_val(&st->p[1], i, j);
+		m3 = matrix_val(&st->p[2], i, j);
+		m4 = matrix_val(&st->c[0], i, j);
+		m5 = matrix_val(&st->c[3], i, j);
+		m6 = matrix_val(&st->c[1], i, j);
+		m7 = matrix_val(&st->c[2], i, j);
+		
+		u2 = m1 + m6;
+		u3 = u2 + m7;
+		matrix_ref(&st->c[0], i, j) = m1 + m2;
+		matrix_ref(&st->c[1], i, j) = u2 + m5 + m3;
+		matrix_ref(&st->c[2], i, j) = u3 - m4;
+		matrix_ref(&st->c[3], i, j) = u3 + m5;
+	}
+}
+
+/*
+ * Producto de Strassen-Winograd (secuencial) de
+ * una franja de filas.
+ */
+static void product_job(void *args) {
+	strassen_job_t *job = (strassen_job_t *) args;
+	
+	winograd(&job->a, &job->b, &job->c, job->levels, job->ws);
+}
+
+/*
+ * Producto clásico de un bloque de C.
+ */
+static void classic_job(void *args) {
+	strassen_job_t *job = (strassen_job_t *) args;
+	matrix_t bloque;
+	
+	if (job->clear) {
+		bloque = block(&job->c, job->row_begin, job->col_begin, job->row_count,
+				job->col_count);
+		block_clear(&bloque);
+	}
+	
+	matrix_mult(&job->a, &job->b, &job->c, job->row_begin, job->row_count,
+			job->col_begin, job->col_count);
+}
+
+/*
+ * Agrega "band_count" trabajos de sumas, uno por franja.
+ */
+static void add_band_jobs(strassen_t *st, int *count, pool_fn fn) {
+	int i;
+	
+	for (i=0; i < st->thread_count; i++, (*count)++) {
+		st->jobs[*count].fn         = fn;
+		st->jobs[*count].st         = st;
+		st->jobs[*count].band       = i;
+		st->jobs[*count].band_count = st->thread_count;
+	}
+}
+
+/*
+ * Agrega los trabajos de un producto clásico del
+ * bloque de C indicado, dividido en franjas de
+ * filas (una por hilo).
+ */
+static void add_classic_jobs(strassen_t *st, int *count, matrix_t *a, matrix_t *b,
+		matrix_t *c, int row_begin, int row_count, int col_begin, int col_count,
+		bool clear) {
+	
+	strassen_job_t *job;
+	int i, begin, end;
+	
+	if (row_count <= 0 || col_count <= 0)
+		return;
+	
+	for (i=0; i < st->thread_count; i++) {
+		begin = row_begin + (int) ((long) row_count * i / st->thread_count);
+		end   = row_begin + (int) ((long) row_count * (i + 1) / st->thread_count);
+		if (begin == end)
+			continue;
+		
+		job = &st->jobs[(*count)++];
+		job->fn        = classic_job;
+		job->st        = st;
+		job->a         = *a;
+		job->b         = *b;
+		job->c         = *c;
+		job->row_begin = begin;
+		job->row_count = end - begin;
+		job->col_begin = col_begin;
+		job->col_count = col_count;
+		job->clear     = clear;
+	}
+}
+
+/*
+ * Ejecuta los trabajos en el pool y espera a que
+ * terminen, o en el hilo actual si no hay pool.
+ */
+static void run_jobs(strassen_t *st, int count) {
+	int i;
+	
+	if (st->pool == NULL) {
+		for (i=0; i < count; i++)
+			st->jobs[i].fn(&st->jobs[i]);
+		return;
+	}
+	
+	for (i=0; i < count; i++)
+		pool_submit(st->pool, st->jobs[i].fn, &st->jobs[i]);
+	pool_wait(st->pool);
+}
+
+void strassen_create(strassen_t **st, pool_t *pool, int thread_count,
+		int m, int k, int n, int cutoff) {
+	
+	int m2, k2, n2, units, band_rows, i;
+	size_t size;
+	matrix_elem_t *ws;
+	
+	(*st) = GET_MEM(strassen_t, 1);
+	memset(*st, 0, sizeof(strassen_t));
+	
+	(*st)->pool         = pool;
+	(*st)->thread_count = pool != NULL ? MAX(thread_count, 1) : 1;
+	(*st)->m            = m;
+	(*st)->k            = k;
+	(*st)->n            = n;
+	(*st)->cutoff       = MAX(cutoff, STRASSEN_MIN_CUTOFF);
+	(*st)->bands        = 1;
+	
+	/*
+	 * Niveles de recursión: mientras la menor dimensión
+	 * supere el corte. El núcleo es la mayor porción
+	 * con dimensiones múltiplo de 2^levels.
+	 */
+	while (MIN(MIN(m >> (*st)->levels, k >> (*st)->levels), n >> (*st)->levels) >
+			(*st)->cutoff)
+		(*st)->levels++;
+	
+	if ((*st)->levels > 0) {
+		(*st)->m0 = m & ~((1 << (*st)->levels) - 1);
+		(*st)->k0 = k & ~((1 << (*st)->levels) - 1);
+		(*st)->n0 = n & ~((1 << (*st)->levels) - 1);
+		
+		m2 = (*st)->m0 / 2;
+		k2 = (*st)->k0 / 2;
+		n2 = (*st)->n0 / 2;
+		
+		/*
+		 * Con más de siete hilos, cada producto del primer
+		 * nivel se divide en franjas de filas, múltiplo
+		 * de 2^(levels - 1) para poder seguir recursando.
+		 */
+		units          = (*st)->m0 >> (*st)->levels;
+		(*st)->bands   = MIN(units, ((*st)->thread_count + STRASSEN_PRODUCTS - 1) /
+				STRASSEN_PRODUCTS);
+		band_rows      = (units + (*st)->bands - 1) / (*st)->bands << ((*st)->levels - 1);
+		(*st)->task_ws_size = winograd_size(band_rows, k2, n2, (*st)->levels - 1);
+		
+		size = 4 * (size_t) m2 * temp_ld(k2) + 4 * (size_t) k2 * temp_ld(n2) +
+				3 * (size_t) m2 * temp_ld(n2) +
+				(size_t) STRASSEN_PRODUCTS * (*st)->bands * (*st)->task_ws_size;
+		
+		(*st)->workspace = GET_MEM_ALIGNED(matrix_elem_t, size);
+		memset((*st)->workspace, 0, size * sizeof(matrix_elem_t));
+		
+		ws = (*st)->workspace;
+		for (i=0; i < 4; i++, ws += (size_t) m2 * temp_ld(k2))
+			(*st)->s[i] = temp(ws, m2, k2);
+		for (i=0; i < 4; i++, ws += (size_t) k2 * temp_ld(n2))
+			(*st)->t[i] = temp(ws, k2, n2);
+		for (i=0; i < 3; i++, ws += (size_t) m2 * temp_ld(n2))
+			(*st)->p[i] = temp(ws, m2, n2);
+		(*st)->task_ws = ws;
+	}
+	
+	/*
+	 * Trabajos de la fase más larga: los productos
+	 * y las dos franjas del borde.
+	 */
+	(*st)->job_max = STRASSEN_PRODUCTS * (*st)->bands + 2 * (*st)->thread_count;
+	(*st)->jobs    = GET_MEM(strassen_job_t, (*st)->job_max);
+	memset((*st)->jobs, 0, (*st)->job_max * sizeof(strassen_job_t));
+}
+
+void strassen_destroy(strassen_t *st) {
+	free(st->workspace);
+	free(st->jobs);
+	free(st);
+}
+
+void strassen_mult(strassen_t *st, matrix_t *a, matrix_t *b, matrix_t *c) {
+	matrix_t *factor_a[STRASSEN_PRODUCTS], *factor_b[STRASSEN_PRODUCTS];
+	matrix_t *producto[STRASSEN_PRODUCTS];
+	matrix_t borde_a, borde_b;
+	strassen_job_t *job;
+	int m2, k2, n2, units, begin, end, rows, levels;
+	int count = 0, i, j;
+	
+	if (matrix_rows(a) != st->m || matrix_cols(a) != st->k || matrix_rows(b) != st->k ||
+			matrix_cols(b) != st->n || matrix_rows(c) != st->m || matrix_cols(c) != st->n)
+		LOG(FATAL, "%s(): %s", __func__,
+				"Las dimensiones no coinciden con las de strassen_create().");
+	
+	if (st->levels > 0) {
+		m2 = st->m0 / 2;
+		k2 = st->k0 / 2;
+		n2 = st->n0 / 2;
+		
+		for (i=0; i < 4; i++) {
+			st->a[i] = block(a, i / 2 * m2, i % 2 * k2, m2, k2);
+			st->b[i] = block(b, i / 2 * k2, i % 2 * n2, k2, n2);
+			st->c[i] = block(c, i / 2 * m2, i % 2 * n2, m2, n2);
+		}
+		
+		/*
+		 * Fase 1: S1..S4 y T1..T4.
+		 */
+		add_band_jobs(st, &count, pre_add_job);
+		run_jobs(st, count);
+		count = 0;
+		
+		/*
+		 * Fase 2: los siete productos, en franjas de filas,
+		 * junto con los bordes derecho e inferior de C.
+		 */
+		factor_a[0] = &st->a[0];	factor_b[0] = &st->b[0];	producto[0] = &st->p[0];
+		factor_a[1] = &st->a[1];	factor_b[1] = &st->b[2];	producto[1] = &st->p[1];
+		factor_a[2] = &st->s[3];	factor_b[2] = &st->b[3];	producto[2] = &st->p[2];
+		factor_a[3] = &st->a[3];	factor_b[3] = &st->t[3];	producto[3] = &st->c[0];
+		factor_a[4] = &st->s[0];	factor_b[4] = &st->t[0];	producto[4] = &st->c[3];
+		factor_a[5] = &st->s[1];	factor_b[5] = &st->t[1];	producto[5] = &st->c[1];
+		factor_a[6] = &st->s[2];	factor_b[6] = &st->t[2];	producto[6] = &st->c[2];
+		
+		units = st->m0 >> st->levels;
+		
+		for (i=0; i < STRASSEN_PRODUCTS; i++)
+		for (j=0; j < st->bands; j++) {
+			begin = (int) ((long) units * j / st->bands) << (st->levels - 1);
+			end   = (int) ((long) units * (j + 1) / st->bands) << (st->levels - 1);
+			rows  = end - begin;
+			if (rows == 0)
+				continue;
+			
+			// Niveles restantes para la franja
+			for (levels=0; levels < st->levels - 1 &&
+					MIN(MIN(rows >> levels, k2 >> levels), n2 >> levels) > st->cutoff;
+					levels++)
+				;
+			
+			job = &st->jobs[count];
+			job->fn     = product_job;
+			job->st     = st;
+			job->a      = block(factor_a[i], begin, 0, rows, k2);
+			job->b      = *factor_b[i];
+			job->c      = block(producto[i], begin, 0, rows, n2);
+			job->levels = levels;
+			job->ws     = st->task_ws + (size_t) count * st->task_ws_size;
+			count++;
+		}
+	}
+	
+	add_classic_jobs(st, &count, a, b, c, 0, st->m0, st->n0, st->n - st->n0, true);
+	add_classic_jobs(st, &count, a, b, c, st->m0, st->m - st->m0, 0, st->n, true);
+	run_jobs(st, count);
+	count = 0;
+	
+	if (st->levels == 0)
+		return;
+	
+	/*
+	 * Fase 3: C11..C22 a partir de M1..M7.
+	 */
+	add_band_jobs(st, &count, post_add_job);
+	run_jobs(st, count);
+	count = 0;
+	
+	/*
+	 * Fase 4: columnas de A (y filas de B) que
+	 * quedaron fuera del núcleo.
+	 */
+	if (st->k0 < st->k) {
+		borde_a = block(a, 0, st->k0, st->m0, st->k - st->k0);
+		borde_b = block(b, st->k0, 0, st->k - st->k0, st->n0);
+		add_classic_jobs(st, &count, &borde_a, &borde_b, c, 0, st->m0, 0, st->n0, false);
+		run_jobs(st, count);
+	}
+}
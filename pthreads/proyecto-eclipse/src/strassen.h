@@ -0,0 +1,92 @@
+#ifndef STRASSEN_H_
+#define STRASSEN_H_
+
+#include "matrix.h"
+#include "pool.h"
+
+/*
+ * Corte mínimo de la recursión: por debajo de
+ * este tamaño el ahorro de operaciones no
+ * compensa las sumas adicionales.
+ */
+#define STRASSEN_MIN_CUTOFF 32
+
+/*
+ * Cantidad de productos de cada nivel de
+ * Strassen-Winograd.
+ */
+#define STRASSEN_PRODUCTS 7
+
+typedef struct strassen_job strassen_job_t;
+
+/*
+ * Multiplicación de Strassen-Winograd sobre matrices
+ * de m x k por k x n.
+ *
+ * Se recursa "levels" niveles, mientras la menor de
+ * las dimensiones supere el corte, y por debajo se
+ * usa matrix_mult(). Los siete productos del primer
+ * nivel se ejecutan en paralelo en el pool (en
+ * "bands" franjas de filas cada uno si hay más de
+ * siete hilos), y los niveles siguientes en forma
+ * secuencial dentro de cada trabajo, con dos
+ * temporales por nivel.
+ *
+ * Para dimensiones que no son múltiplo de 2^levels
+ * se pela el borde: el núcleo de m0 x k0 por k0 x n0
+ * se multiplica con Strassen-Winograd, y las franjas
+ * restantes con matrix_mult().
+ *
+ * Todos los temporales salen de "workspace", que se
+ * asigna (y se toca por primera vez) al crearlo.
+ */
+struct strassen {
+	pool_t *pool;			// Nulo: ejecución secuencial
+	int thread_count;
+	int m, k, n;
+	int cutoff;
+	int levels;
+	int m0, k0, n0;			// Dimensiones del núcleo
+	int bands;				// Franjas de filas por producto
+	
+	matrix_elem_t *workspace;
+	size_t task_ws_size;	// Elementos de cada trabajo de producto
+	matrix_elem_t *task_ws;
+	
+	/*
+	 * Cuadrantes del núcleo y temporales del primer
+	 * nivel: S1..S4 (de A), T1..T4 (de B) y los
+	 * productos M1..M3 (M4..M7 se guardan en C).
+	 */
+	matrix_t a[4], b[4], c[4];
+	matrix_t s[4], t[4], p[3];
+	
+	strassen_job_t *jobs;
+	int job_max;
+};
+
+typedef struct strassen strassen_t;
+
+/*
+ * Crea una multiplicación de Strassen-Winograd para
+ * matrices de m x k por k x n con el corte indicado
+ * (se usa al menos STRASSEN_MIN_CUTOFF). Si "pool" no
+ * es nulo, se reparte el trabajo entre sus
+ * "thread_count" hilos.
+ */
+void strassen_create(strassen_t **st, pool_t *pool, int thread_count,
+		int m, int k, int n, int cutoff);
+
+/*
+ * Destruye una multiplicación de Strassen-Winograd
+ * y su espacio de trabajo.
+ */
+void strassen_destroy(strassen_t *st);
+
+/*
+ * Calcula C = A x B (sobrescribe C). Las dimensiones
+ * deben ser las indicadas en strassen_create().
+ */
+void strassen_mult(strassen_t *st, matrix_t *a, matrix_t *b, matrix_t *c);
+
+#endif /*STRASSEN_H_*/
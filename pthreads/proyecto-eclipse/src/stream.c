@@ -0,0 +1,154 @@
+#include "stream.h"
+#include "matrix_file.h"
+#include "sched.h"
+#include <fcntl.h>
+
+/*
+ * Escribe "text" en la posición actual del archivo.
+ */
+static void write_text(stream_t *stream, const char *text) {
+	if (stream->ok)
+		stream->ok = matrix_file_pwrite(stream->fd, text, strlen(text), stream->offset);
+	stream->offset += strlen(text);
+}
+
+/*
+ * Escribe la matriz completa "mat" precedida por
+ * su título y seguida por una línea en blanco,
+ * como print_matrices().
+ */
+static void write_matrix(stream_t *stream, const char *title, matrix_t *mat) {
+	write_text(stream, title);
+	stream->offset = matrix_file_print(mat, stream->fd, stream->offset, NULL, 1);
+	write_text(stream, "\n");
+}
+
+/*
+ * Hilo escritor. Imprime A y B y luego, en orden,
+ * cada tramo de filas de C completas, sin retener
+ * el mutex mientras escribe.
+ */
+static void *writer_thread(void *args) {
+	stream_t *stream = (stream_t *) args;
+	int rows = matrix_rows(stream->matrix_c);
+	long long begin;
+	int end;
+	
+	begin = get_time_nanos();
+	write_matrix(stream, "Matriz A\n", stream->matrix_a);
+	write_matrix(stream, "Matriz B\n", stream->matrix_b);
+	write_text(stream, "Matriz C\n");
+	stream->write_nanos += get_time_nanos() - begin;
+	
+	pthread_mutex_lock(&stream->mutex);
+	while (stream->next < rows) {
+		end = stream->next;
+		while (end < rows && stream->pending[end] == 0)
+			end++;
+		
+		if (end == stream->next) {
+			begin = get_time_nanos();
+			pthread_cond_wait(&stream->rows_ready, &stream->mutex);
+			stream->wait_nanos += get_time_nanos() - begin;
+			continue;
+		}
+		pthread_mutex_unlock(&stream->mutex);
+		
+		begin = get_time_nanos();
+		stream->offset = matrix_file_print_rows(stream->matrix_c, stream->next, end,
+				stream->fd, stream->offset, NULL, 1);
+		stream->write_nanos += get_time_nanos() - begin;
+		
+		pthread_mutex_lock(&stream->mutex);
+		stream->next = end;
+	}
+	pthread_mutex_unlock(&stream->mutex);
+	
+	write_text(stream, "\n");
+	
+	return NULL;
+}
+
+/*
+ * Suma a "pending" un bloque de filas de C.
+ */
+static void add_block(stream_t *stream, int row_begin, int row_count) {
+	int i;
+	
+	for (i=row_begin; i < row_begin + row_count; i++)
+		stream->pending[i]++;
+}
+
+bool stream_create(stream_t **stream, const char *path, matrix_t *mat_a,
+		matrix_t *mat_b, matrix_t *mat_c, matrix_mult_args *arguments,
+		int thread_count) {
+	
+	sched_t *sched = arguments[0].sched;
+	int fd, i;
+	
+	if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+		return false;
+	
+	(*stream) = GET_MEM(stream_t, 1);
+	memset(*stream, 0, sizeof(stream_t));
+	
+	(*stream)->matrix_a = mat_a;
+	(*stream)->matrix_b = mat_b;
+	(*stream)->matrix_c = mat_c;
+	(*stream)->fd       = fd;
+	(*stream)->ok       = true;
+	
+	/*
+	 * Cada fila de C la escriben todos los bloques
+	 * que la cubren (con 2d o con bloques dinámicos,
+	 * uno por cada franja de columnas).
+	 */
+	(*stream)->pending = GET_MEM(int, matrix_rows(mat_c));
+	memset((*stream)->pending, 0, matrix_rows(mat_c) * sizeof(int));
+	
+	if (sched != NULL)
+		for (i=0; i < sched->tile_count; i++)
+			add_block(*stream, sched->tiles[i].row_begin, sched->tiles[i].row_count);
+	else
+		for (i=0; i < thread_count; i++)
+			if (arguments[i].col_count > 0)
+				add_block(*stream, arguments[i].row_begin, arguments[i].row_count);
+	
+	pthread_mutex_init(&(*stream)->mutex, NULL);
+	pthread_cond_init(&(*stream)->rows_ready, NULL);
+	
+	if (pthread_create(&(*stream)->writer, NULL, writer_thread, *stream) != 0)
+		LOG(FATAL, "%s(): %s", __func__, "Error en creación del hilo escritor.");
+	
+	return true;
+}
+
+void stream_rows_done(stream_t *stream, int row_begin, int row_count) {
+	bool ready = false;
+	int i;
+	
+	pthread_mutex_lock(&stream->mutex);
+	for (i=row_begin; i < row_begin + row_count; i++)
+		ready = (--stream->pending[i] == 0) || ready;
+	
+	if (ready)
+		pthread_cond_signal(&stream->rows_ready);
+	pthread_mutex_unlock(&stream->mutex);
+}
+
+bool stream_finish(stream_t *stream) {
+	if (pthread_join(stream->writer, NULL) != 0)
+		LOG(FATAL, "%s(): %s", __func__, "Error en 'join' del hilo escritor.");
+	
+	close(stream->fd);
+	
+	return stream->ok;
+}
+
+void stream_destroy(stream_t *stream) {
+	pthread_mutex_destroy(&stream->mutex);
+	pthread_cond_destroy(&stream->rows_ready);
+	
+	free(stream->pending);
+	free(stream);
+}
@@ -0,0 +1,77 @@
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#include "matrix.h"
+
+/*
+ * Cantidad de franjas de filas en que se divide
+ * cada bloque de C al multiplicar con escritura
+ * en flujo, y mínimo de filas por franja (para que
+ * el empaquetado de B de cada franja se amortice).
+ */
+#define STREAM_BANDS_PER_BLOCK 8
+#define STREAM_MIN_BAND_ROWS   32
+
+/*
+ * Escritura en flujo del archivo de matrices: un
+ * hilo escritor imprime A y B mientras se multiplica
+ * y luego las filas de C, en orden, a medida que
+ * quedan completas.
+ *
+ * "pending" lleva, por cada fila de C, la cantidad
+ * de bloques que aún deben escribirla; la fila está
+ * completa cuando llega a cero. "next" es la primera
+ * fila de C aún no impresa.
+ */
+struct stream {
+	matrix_t *matrix_a;
+	matrix_t *matrix_b;
+	matrix_t *matrix_c;
+	
+	int *pending;
+	int next;
+	
+	pthread_mutex_t mutex;
+	pthread_cond_t rows_ready;	// Alguna fila de C quedó completa
+	pthread_t writer;
+	
+	int fd;
+	off_t offset;
+	bool ok;
+	
+	long long write_nanos;		// Tiempo del escritor imprimiendo
+	long long wait_nanos;		// Tiempo del escritor esperando filas
+};
+
+/*
+ * Abre el archivo "path" y comienza la escritura en
+ * flujo de las matrices. Las filas de C se esperan de
+ * los bloques de las particiones de "arguments" (o de
+ * los bloques del planificador, si lo tienen), cada
+ * una informada con stream_rows_done(). Las
+ * particiones no pueden dividir la dimensión común.
+ * Retorna false si no se pudo abrir el archivo.
+ */
+bool stream_create(stream_t **stream, const char *path, matrix_t *mat_a,
+		matrix_t *mat_b, matrix_t *mat_c, matrix_mult_args *arguments,
+		int thread_count);
+
+/*
+ * Informa que las filas [row_begin, row_begin + row_count)
+ * de un bloque de C ya tienen su valor final.
+ */
+void stream_rows_done(stream_t *stream, int row_begin, int row_count);
+
+/*
+ * Espera a que el escritor imprima todas las filas
+ * de C (todas deben haberse informado) y cierra el
+ * archivo. Retorna false si hubo errores de escritura.
+ */
+bool stream_finish(stream_t *stream);
+
+/*
+ * Destruye la escritura en flujo, una vez terminada.
+ */
+void stream_destroy(stream_t *stream);
+
+#endif /*STREAM_H_*/
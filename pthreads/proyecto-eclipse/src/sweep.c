@@ -0,0 +1,427 @@
+#include "sweep.h"
+
+/*
+ * Lee una lista de enteros no negativos separados
+ * por comas ("400,800,1200"). Retorna la cantidad
+ * de valores leídos, o 0 si la lista no es válida.
+ */
+static int parse_list(char *arg, int *values, int max) {
+	char buf[256], *token, *save;
+	int count = 0;
+	
+	if (strlen(arg) >= sizeof(buf))
+		return 0;
+	strcpy(buf, arg);
+	
+	for (token=strtok_r(buf, ",", &save); token != NULL; token=strtok_r(NULL, ",", &save)) {
+		if (count == max || !is_number(token))
+			return 0;
+		
+		values[count++] = atoi(token);
+	}
+	
+	return count;
+}
+
+bool sweep_requested(int argc, char **argv) {
+	return argc > 1 && strcmp(argv[1], "--sweep") == 0;
+}
+
+void sweep_params(sweep_t *sweep, int argc, char **argv) {
+	bool condicion = true;
+	int i, j;
+	
+	memset(sweep, 0, sizeof(sweep_t));
+	
+	// Valores por defecto
+	sweep->threads[0]    = 0;
+	sweep->thread_count  = 1;
+	sweep->distribs[0]   = 1;
+	sweep->distrib_count = 1;
+	sweep->warmup        = 1;
+	sweep->reps          = 5;
+	
+	for (i=2; i < argc && condicion; i++) {
+		if (strcmp(argv[i], "--counters") == 0) {
+			sweep->counters = true;
+			continue;
+		}
+		if (strcmp(argv[i], "--hugepages") == 0) {
+			sweep->hugepages = true;
+			continue;
+		}
+		
+		/*
+		 * Las demás opciones llevan al menos
+		 * un argumento.
+		 */
+		condicion = i + 1 < argc;
+		if (!condicion)
+			break;
+		
+		if (strcmp(argv[i], "-s") == 0) {
+			sweep->size_count = parse_list(argv[i + 1], sweep->sizes, SWEEP_MAX_VALUES);
+			condicion = sweep->size_count > 0;
+			
+			for (j=0; j < sweep->size_count; j++)
+				if (sweep->sizes[j] == 0)
+					condicion = false;
+		}
+		else if (strcmp(argv[i], "-h") == 0) {
+			sweep->thread_count = parse_list(argv[i + 1], sweep->threads, SWEEP_MAX_VALUES);
+			condicion = sweep->thread_count > 0;
+			
+			for (j=0; j < sweep->thread_count; j++)
+				sweep->threads[j] = MIN(sweep->threads[j], MAX_THREADS);
+		}
+		else if (strcmp(argv[i], "-t") == 0) {
+			sweep->distrib_count = parse_list(argv[i + 1], sweep->distribs, SWEEP_MAX_VALUES);
+			condicion = sweep->distrib_count > 0;
+			
+			// Tipo de distribución debe ser 1d, 2d, dinámica o 3d
+			for (j=0; j < sweep->distrib_count; j++)
+				if (sweep->distribs[j] < 1 || sweep->distribs[j] > 4)
+					condicion = false;
+		}
+		else if (strcmp(argv[i], "-w") == 0) {
+			condicion = is_number(argv[i + 1]);
+			sweep->warmup = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-r") == 0) {
+			condicion = is_number(argv[i + 1]) && atoi(argv[i + 1]) > 0;
+			sweep->reps = atoi(argv[i + 1]);
+		}
+		else if (strcmp(argv[i], "-tb") == 0) {
+			condicion = i + 3 < argc &&
+						is_number(argv[i + 1]) &&
+						is_number(argv[i + 2]) &&
+						is_number(argv[i + 3]);
+			
+			if (condicion) {
+				sweep->tile_kc = atoi(argv[i + 1]);
+				sweep->tile_mc = atoi(argv[i + 2]);
+				sweep->tile_nc = atoi(argv[i + 3]);
+				i += 2;
+			}
+		}
+		else
+			condicion = false;
+		
+		// Avanzamos el indice
+		i += 1;
+	}
+	
+	/*
+	 * Los tamaños son obligatorios.
+	 */
+	if (!condicion || sweep->size_count == 0)
+		como_usar();
+}
+
+static int compare_doubles(const void *a, const void *b) {
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+	
+	return (x > y) - (x < y);
+}
+
+/*
+ * Calcula mediana, mínimo, promedio y desvío
+ * estándar de "count" muestras (las ordena).
+ */
+static void sweep_stats(double *samples, int count, sweep_result_t *result) {
+	double suma = 0.0, desvio = 0.0;
+	int i;
+	
+	qsort(samples, count, sizeof(double), compare_doubles);
+	
+	for (i=0; i < count; i++)
+		suma += samples[i];
+	result->mean = suma / count;
+	
+	for (i=0; i < count; i++)
+		desvio += (samples[i] - result->mean) * (samples[i] - result->mean);
+	result->stddev = count > 1 ? sqrt(desvio / (count - 1)) : 0.0;
+	
+	result->min    = samples[0];
+	result->median = count % 2 == 1 ? samples[count / 2] :
+			(samples[count / 2 - 1] + samples[count / 2]) / 2.0;
+}
+
+/*
+ * Realiza una multiplicación y retorna su duración
+ * en nanosegundos, medida como TTM: particionamiento,
+ * despacho y ejecución de los hilos. Si "total" no es
+ * nulo, se le suman los contadores de hardware de
+ * todos los hilos.
+ */
+static long long sweep_mult(pool_t *pool, matrix_t *a, matrix_t *b, matrix_t *c,
+		int threads, int distrib, matrix_mult_args *arguments, counters_t *total) {
+	
+	time_rec_t tiempo = {0};
+	counter_set_t contadores;
+	counters_t valores;
+	int i;
+	
+	matrix_clear(c, 0, matrix_rows(c), 0, matrix_cols(c));
+	
+	if (threads == 0 && total != NULL)
+		counters_start(&contadores);
+	
+	TIME_BEGIN(tiempo);
+	
+	if (threads == 0)
+		matrix_mult(a, b, c, 0, matrix_rows(c), 0, matrix_cols(c));
+	else {
+		memset(arguments, 0, threads * sizeof(matrix_mult_args));
+		distribute(distrib, a, b, c, threads, arguments);
+		
+		for (i=0; i < threads; i++) {
+			arguments[i].counters_enabled = total != NULL;
+			pool_submit(pool, matrix_mult_thread, &arguments[i]);
+		}
+		pool_wait(pool);
+		reduce_partials(pool, arguments, threads);
+	}
+	
+	TIME_END(tiempo);
+	
+	if (total != NULL) {
+		if (threads == 0) {
+			counters_stop(&contadores, &valores);
+			counters_add(total, &valores);
+		}
+		
+		for (i=0; i < threads; i++)
+			counters_add(total, &arguments[i].counters);
+	}
+	
+	if (threads > 0)
+		distrib_release(arguments, threads);
+	
+	return TIME_DIFF(tiempo);
+}
+
+/*
+ * Calcula las operaciones por segundo de cada
+ * configuración y, contra la multiplicación
+ * secuencial del mismo tamaño (medida en el barrido
+ * o guardada en BASELINE_FILE), la aceleración y la
+ * eficiencia, y su ubicación en el modelo "roofline".
+ * Las medianas secuenciales medidas se guardan como
+ * referencia.
+ */
+static void sweep_metrics(sweep_result_t *results, int count, const roofline_t *roof) {
+	baseline_key_t key;
+	long long base;
+	int i, j;
+	
+	for (i=0; i < count; i++) {
+		results[i].gops = MATRIX_MULT_OPS(results[i].size, results[i].size, 
+				results[i].size) / results[i].median;
+		
+		baseline_key_init(&key, results[i].size, results[i].size, results[i].size, 0);
+		if (results[i].threads == 0)
+			baseline_store(&key, (long long) results[i].median);
+		
+		// Referencia secuencial del mismo tamaño
+		base = 0;
+		for (j=0; j < count && base == 0; j++)
+			if (results[j].threads == 0 && results[j].size == results[i].size)
+				base = (long long) results[j].median;
+		
+		if (base == 0 && !baseline_load(&key, &base))
+			base = 0;
+		
+		results[i].speedup    = base > 0 ? base / results[i].median : 0.0;
+		results[i].efficiency = results[i].speedup / MAX(results[i].threads, 1);
+		
+		roofline_place(roof, MATRIX_MULT_OPS(results[i].size, results[i].size, 
+				results[i].size), roofline_traffic(results[i].size, results[i].size, 
+				results[i].size), results[i].median, results[i].threads, 
+				&results[i].roofline);
+	}
+}
+
+/*
+ * Imprime los resultados del barrido en CSV y JSON.
+ */
+static void sweep_print(sweep_t *sweep, sweep_result_t *results, int count,
+		const roofline_t *roof) {
+	FILE *archivo = NULL;
+	int i, j;
+	
+	if ((archivo = fopen(SWEEP_CSV_FILE, "w")) == NULL) {
+		LOG(WARN, "Error al abrir archivo de barrido \"%s\".", SWEEP_CSV_FILE);
+	}
+	else {
+		fprintf(archivo, "N,Hilos,Part,Reps,Mediana,Min,Promedio,Desvio,%s,Aceleracion,Eficiencia,Intensidad,FraccionPico,Limite",
+				MATRIX_OPS_UNIT);
+		for (j=0; sweep->counters && j < COUNTER_COUNT; j++)
+			fprintf(archivo, ",%s", counter_name(j));
+		fprintf(archivo, "\n");
+		
+		for (i=0; i < count; i++) {
+			fprintf(archivo, "%d,%d,%d,%d,%.0f,%.0f,%.0f,%.0f,%f,%f,%f,%f,%f,%s", results[i].size,
+					results[i].threads, results[i].distrib, sweep->reps,
+					results[i].median, results[i].min, results[i].mean,
+					results[i].stddev, results[i].gops, results[i].speedup,
+					results[i].efficiency, results[i].roofline.intensity,
+					results[i].roofline.peak > 0.0 ? 
+							results[i].roofline.achieved / results[i].roofline.peak : 0.0,
+					results[i].roofline.memory_bound ? "memoria" : "computo");
+			for (j=0; sweep->counters && j < COUNTER_COUNT; j++)
+				fprintf(archivo, ",%lld", results[i].counters.values[j]);
+			fprintf(archivo, "\n");
+		}
+		fclose(archivo);
+	}
+	
+	if ((archivo = fopen(SWEEP_JSON_FILE, "w")) == NULL) {
+		LOG(WARN, "Error al abrir archivo de barrido \"%s\".", SWEEP_JSON_FILE);
+	}
+	else {
+		fprintf(archivo, "{\n  \"kernel\": \"%s\",\n  \"warmup\": %d,\n  \"reps\": %d,\n",
+				gemm_kernel_get()->name, sweep->warmup, sweep->reps);
+		fprintf(archivo, "  \"bandwidth\": %f,\n  \"peak_core\": %f,\n", roof->bandwidth,
+				roof->peak_core);
+		fprintf(archivo, "  \"unit\": \"ns\",\n  \"ops_unit\": \"%s\",\n  \"results\": [\n",
+				MATRIX_OPS_UNIT);
+		for (i=0; i < count; i++) {
+			fprintf(archivo, "    {\"n\": %d, \"threads\": %d, \"distrib\": %d, "
+					"\"median\": %.0f, \"min\": %.0f, \"mean\": %.0f, \"stddev\": %.0f, "
+					"\"ops\": %f, \"speedup\": %f, \"efficiency\": %f, "
+					"\"intensity\": %f, \"peak_fraction\": ",
+					results[i].size, results[i].threads, results[i].distrib,
+					results[i].median, results[i].min, results[i].mean,
+					results[i].stddev, results[i].gops, results[i].speedup,
+					results[i].efficiency, results[i].roofline.intensity);
+			
+			// Sin techo de cómputo calibrado, la fracción no está definida
+			if (results[i].roofline.peak > 0.0)
+				fprintf(archivo, "%f", results[i].roofline.achieved / results[i].roofline.peak);
+			else
+				fprintf(archivo, "null");
+			
+			fprintf(archivo, ", \"bound\": \"%s\"", 
+					results[i].roofline.memory_bound ? "memory" : "compute");
+			for (j=0; sweep->counters && j < COUNTER_COUNT; j++)
+				fprintf(archivo, ", \"%s\": %lld", counter_name(j), results[i].counters.values[j]);
+			fprintf(archivo, "}%s\n", i + 1 < count ? "," : "");
+		}
+		fprintf(archivo, "  ]\n}\n");
+		fclose(archivo);
+	}
+}
+
+void sweep_run(sweep_t *sweep) {
+	matrix_t *base_a, *base_b, *base_c;
+	matrix_t mat_a, mat_b, mat_c;
+	matrix_mult_args *arguments;
+	sweep_result_t *results;
+	pool_t *pool = NULL;
+	param_t params = {0};
+	roofline_t roof;
+	double *samples;
+	int max_size = 0, max_threads = 0, count = 0;
+	int s, h, t, r, i, distrib, threads;
+	
+	matrix_tiles_init(sweep->tile_kc, sweep->tile_mc, sweep->tile_nc);
+	gemm_init();
+	roofline_get(&roof);
+	
+	for (s=0; s < sweep->size_count; s++)
+		max_size = MAX(max_size, sweep->sizes[s]);
+	for (h=0; h < sweep->thread_count; h++)
+		max_threads = MAX(max_threads, sweep->threads[h]);
+	
+	/*
+	 * Las matrices, los argumentos y el pool se crean
+	 * una sola vez, para el mayor tamaño y la mayor
+	 * cantidad de hilos. Cada tamaño usa vistas sobre
+	 * los mismos bloques.
+	 */
+	LOG(INFO, "Barrido: %d tamaño(s), %d cantidad(es) de hilos, %d particionamiento(s).",
+			sweep->size_count, sweep->thread_count, sweep->distrib_count);
+	matrix_hugepages_set(sweep->hugepages);
+	matrix_alloc(&base_a, max_size, max_size);
+	matrix_alloc(&base_b, max_size, max_size);
+	matrix_alloc(&base_c, max_size, max_size);
+	
+	arguments = GET_MEM(matrix_mult_args, MAX(max_threads, 1));
+	results   = GET_MEM(sweep_result_t, sweep->size_count * sweep->thread_count *
+			sweep->distrib_count);
+	samples   = GET_MEM(double, sweep->reps);
+	
+	if (max_threads > 0)
+		pool_create(&pool, max_threads);
+	
+	fprintf(stdout, "\n%-7s %-6s %-9s %-14s %-14s %-14s\n", "N", "Hilos", "Part",
+			"Mediana", "Min", "Desvio");
+	
+	for (s=0; s < sweep->size_count; s++) {
+		matrix_view(&mat_a, base_a, sweep->sizes[s], sweep->sizes[s]);
+		matrix_view(&mat_b, base_b, sweep->sizes[s], sweep->sizes[s]);
+		matrix_view(&mat_c, base_c, sweep->sizes[s], sweep->sizes[s]);
+		
+		matrix_fill_rows(&mat_a, 0, matrix_rows(&mat_a), (unsigned int) time(NULL));
+		matrix_fill_rows(&mat_b, 0, matrix_rows(&mat_b), ~(unsigned int) time(NULL));
+		
+		for (h=0; h < sweep->thread_count; h++)
+		for (t=0; t < sweep->distrib_count; t++) {
+			// La multiplicación secuencial no depende del particionamiento
+			if (sweep->threads[h] == 0 && t > 0)
+				continue;
+			
+			distrib = sweep->threads[h] == 0 ? 0 : sweep->distribs[t];
+			threads = sweep->threads[h];
+			
+			if (threads > 0) {
+				params.matrix_a_fil = params.matrix_a_col = sweep->sizes[s];
+				params.matrix_b_fil = params.matrix_b_col = sweep->sizes[s];
+				params.thread_count = threads;
+				params.distrib_type = distrib;
+				adjust_thread_count(&params);
+				threads = params.thread_count;
+			}
+			
+			memset(&results[count].counters, 0, sizeof(counters_t));
+			
+			for (r=0; r < sweep->warmup; r++)
+				sweep_mult(pool, &mat_a, &mat_b, &mat_c, threads, distrib, arguments, NULL);
+			for (r=0; r < sweep->reps; r++)
+				samples[r] = sweep_mult(pool, &mat_a, &mat_b, &mat_c, threads, distrib,
+						arguments, sweep->counters ? &results[count].counters : NULL);
+			
+			for (i=0; i < COUNTER_COUNT; i++)
+				if (results[count].counters.values[i] > 0)
+					results[count].counters.values[i] /= sweep->reps;
+			
+			results[count].size    = sweep->sizes[s];
+			results[count].threads = threads;
+			results[count].distrib = distrib;
+			sweep_stats(samples, sweep->reps, &results[count]);
+			
+			fprintf(stdout, "%-7d %-6d %-9s %-14f %-14f %-14f\n", results[count].size,
+					threads, threads == 0 ? "-" : distrib_name(distrib),
+					NANOS_TO_MILLIS(results[count].median),
+					NANOS_TO_MILLIS(results[count].min),
+					NANOS_TO_MILLIS(results[count].stddev));
+			count++;
+		}
+	}
+	fprintf(stdout, "\n");
+	
+	sweep_metrics(results, count, &roof);
+	sweep_print(sweep, results, count, &roof);
+	
+	if (pool != NULL)
+		pool_destroy(pool);
+	free(samples);
+	free(results);
+	free(arguments);
+	matrix_destroy(base_a);
+	matrix_destroy(base_b);
+	matrix_destroy(base_c);
+	gemm_workspace_release();
+}
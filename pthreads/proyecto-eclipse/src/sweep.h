@@ -0,0 +1,74 @@
+#ifndef SWEEP_H_
+#define SWEEP_H_
+
+#include "config.h"
+
+/*
+ * Máxima cantidad de valores en cada
+ * lista del barrido.
+ */
+#define SWEEP_MAX_VALUES 32
+
+/*
+ * Parámetros del modo barrido: se multiplican
+ * matrices cuadradas de cada tamaño, con cada
+ * cantidad de hilos (0 es secuencial) y cada
+ * tipo de particionamiento, repitiendo cada
+ * configuración "reps" veces luego de "warmup"
+ * ejecuciones descartadas.
+ */
+typedef struct {
+	int sizes[SWEEP_MAX_VALUES];
+	int size_count;
+	int threads[SWEEP_MAX_VALUES];
+	int thread_count;
+	int distribs[SWEEP_MAX_VALUES];
+	int distrib_count;
+	int warmup;
+	int reps;
+	int tile_kc, tile_mc, tile_nc;
+	bool hugepages;
+	bool counters;
+} sweep_t;
+
+/*
+ * Estadísticas de los tiempos (en nanosegundos)
+ * de una configuración del barrido, y operaciones
+ * por segundo, aceleración, eficiencia y ubicación
+ * en el modelo "roofline" calculadas con la mediana.
+ */
+typedef struct {
+	int size;
+	int threads;
+	int distrib;
+	double median;
+	double min;
+	double mean;
+	double stddev;
+	double gops;
+	double speedup;
+	double efficiency;
+	roofline_point_t roofline;
+	counters_t counters;	// Promedio por ejecución (si se midieron)
+} sweep_result_t;
+
+/*
+ * Retorna true si los argumentos solicitan
+ * el modo barrido (--sweep).
+ */
+bool sweep_requested(int argc, char **argv);
+
+/*
+ * Recorre la lista de argumentos del modo
+ * barrido y los almacena en "sweep".
+ */
+void sweep_params(sweep_t *sweep, int argc, char **argv);
+
+/*
+ * Ejecuta el barrido e imprime los resultados
+ * en la salida estándar y en los archivos
+ * SWEEP_CSV_FILE y SWEEP_JSON_FILE.
+ */
+void sweep_run(sweep_t *sweep);
+
+#endif /*SWEEP_H_*/
@@ -0,0 +1,362 @@
+#include "sysinfo.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+
+/*
+ * Lee el registro de control XCR0, que indica
+ * qué estados extendidos (registros YMM, ZMM)
+ * preserva el sistema operativo.
+ */
+static unsigned long long read_xcr0(void) {
+	unsigned int eax, edx;
+	
+	__asm__ volatile ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	return ((unsigned long long) edx << 32) | eax;
+}
+#endif
+
+bool sysfs_read_line(const char *path, char *buf, int size) {
+	FILE *archivo = NULL;
+	int len;
+	
+	if ((archivo = fopen(path, "r")) == NULL)
+		return false;
+	
+	if (fgets(buf, size, archivo) == NULL) {
+		fclose(archivo);
+		return false;
+	}
+	fclose(archivo);
+	
+	// Eliminamos el salto de línea final
+	len = strlen(buf);
+	while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == '\r'))
+		buf[--len] = '\0';
+	
+	return true;
+}
+
+/*
+ * Convierte un tamaño de sysfs del tipo
+ * "48K" o "2M" a bytes.
+ */
+static long parse_size(const char *str) {
+	char *fin;
+	long valor = strtol(str, &fin, 10);
+	
+	if (*fin == 'K')
+		valor *= 1024;
+	else if (*fin == 'M')
+		valor *= 1024 * 1024;
+	else if (*fin == 'G')
+		valor *= 1024 * 1024 * 1024;
+	
+	return valor;
+}
+
+bool cache_info_read(cache_info_t *info) {
+	char path[256], buf[64];
+	int i, level;
+	long size;
+	
+	info->l1 = info->l2 = info->l3 = 0;
+	
+	/*
+	 * Cada directorio indexN describe una caché. Se
+	 * ignoran las cachés de instrucciones.
+	 */
+	for (i=0; ; i++) {
+		snprintf(path, sizeof(path), "%s/index%d/level", SYSFS_CACHE_DIR, i);
+		if (!sysfs_read_line(path, buf, sizeof(buf)))
+			break;
+		level = atoi(buf);
+		
+		snprintf(path, sizeof(path), "%s/index%d/type", SYSFS_CACHE_DIR, i);
+		if (!sysfs_read_line(path, buf, sizeof(buf)) || 
+				strcmp(buf, "Instruction") == 0)
+			continue;
+		
+		snprintf(path, sizeof(path), "%s/index%d/size", SYSFS_CACHE_DIR, i);
+		if (!sysfs_read_line(path, buf, sizeof(buf)))
+			continue;
+		size = parse_size(buf);
+		
+		if (level == 1)
+			info->l1 = size;
+		else if (level == 2)
+			info->l2 = size;
+		else if (level == 3)
+			info->l3 = size;
+	}
+	
+	return info->l1 > 0 || info->l2 > 0 || info->l3 > 0;
+}
+
+void cpu_features_read(cpu_features_t *features) {
+	features->avx2     = false;
+	features->fma      = false;
+	features->avx512f  = false;
+	features->avx512bw = false;
+	
+#if defined(__x86_64__) || defined(__i386__)
+	unsigned int eax, ebx, ecx, edx;
+	unsigned long long xcr0;
+	bool os_avx, os_avx512;
+	
+	if (__get_cpuid_max(0, NULL) < 7)
+		return;
+	
+	/*
+	 * Hoja 1: FMA y soporte de XSAVE por parte
+	 * del sistema operativo (OSXSAVE).
+	 */
+	__cpuid(1, eax, ebx, ecx, edx);
+	if (!(ecx & bit_OSXSAVE))
+		return;
+	
+	xcr0      = read_xcr0();
+	os_avx    = (xcr0 & 0x06) == 0x06;	// Estados SSE y AVX
+	os_avx512 = (xcr0 & 0xE6) == 0xE6;	// Además opmask y ZMM
+	
+	features->fma = os_avx && (ecx & bit_FMA);
+	
+	/*
+	 * Hoja 7: AVX2 y AVX-512.
+	 */
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	features->avx2     = os_avx && (ebx & bit_AVX2);
+	features->avx512f  = os_avx512 && (ebx & bit_AVX512F);
+	features->avx512bw = os_avx512 && (ebx & bit_AVX512BW);
+#endif
+}
+
+/*
+ * Interpreta una lista de procesadores de sysfs
+ * del tipo "0-3,8,10-11". Guarda a lo sumo "max"
+ * procesadores en "cpus" y retorna la cantidad
+ * total encontrada.
+ */
+static int parse_cpulist(const char *str, int *cpus, int max) {
+	int count = 0, desde, hasta, i;
+	char *fin;
+	
+	while (*str != '\0') {
+		desde = hasta = (int) strtol(str, &fin, 10);
+		if (fin == str)
+			break;
+		
+		if (*fin == '-')
+			hasta = (int) strtol(fin + 1, &fin, 10);
+		
+		for (i=desde; i <= hasta; i++, count++)
+			if (cpus != NULL && count < max)
+				cpus[count] = i;
+		
+		str = (*fin == ',') ? fin + 1 : fin;
+	}
+	
+	return count;
+}
+
+/*
+ * Lee un número entero de un archivo de sysfs,
+ * retornando "defecto" si no se puede leer.
+ */
+static int sysfs_read_int(const char *path, int defecto) {
+	char buf[64];
+	
+	if (!sysfs_read_line(path, buf, sizeof(buf)))
+		return defecto;
+	
+	return atoi(buf);
+}
+
+/*
+ * Orden de los procesadores para la asignación:
+ * nodo, luego orden dentro del núcleo (primero un
+ * hilo por núcleo físico), luego socket y núcleo.
+ */
+static int compare_cpus(const void *x, const void *y) {
+	const cpu_info_t *a = (const cpu_info_t *) x;
+	const cpu_info_t *b = (const cpu_info_t *) y;
+	
+	if (a->node != b->node)
+		return a->node - b->node;
+	if (a->smt != b->smt)
+		return a->smt - b->smt;
+	if (a->package != b->package)
+		return a->package - b->package;
+	if (a->core != b->core)
+		return a->core - b->core;
+	return a->cpu - b->cpu;
+}
+
+bool cpu_topology_read(cpu_topology_t *topo) {
+	char path[256], buf[4096];
+	int *lista, count, i, j, node, n;
+	
+	topo->cpus       = NULL;
+	topo->cpu_count  = 0;
+	topo->node_count = 1;
+	
+	snprintf(path, sizeof(path), "%s/online", SYSFS_CPU_DIR);
+	if (!sysfs_read_line(path, buf, sizeof(buf)) || 
+			(count = parse_cpulist(buf, NULL, 0)) <= 0)
+		return false;
+	
+	lista = GET_MEM(int, count);
+	parse_cpulist(buf, lista, count);
+	
+	topo->cpus      = GET_MEM(cpu_info_t, count);
+	topo->cpu_count = count;
+	
+	for (i=0; i < count; i++) {
+		topo->cpus[i].cpu  = lista[i];
+		topo->cpus[i].node = 0;
+		
+		snprintf(path, sizeof(path), "%s/cpu%d/topology/core_id", SYSFS_CPU_DIR, lista[i]);
+		topo->cpus[i].core = sysfs_read_int(path, lista[i]);
+		
+		snprintf(path, sizeof(path), "%s/cpu%d/topology/physical_package_id", 
+				SYSFS_CPU_DIR, lista[i]);
+		topo->cpus[i].package = sysfs_read_int(path, 0);
+	}
+	
+	/*
+	 * Nodos NUMA: cada nodo lista sus procesadores.
+	 */
+	for (node=0; ; node++) {
+		int cpus_nodo[1024];
+		
+		snprintf(path, sizeof(path), "%s/node%d/cpulist", SYSFS_NODE_DIR, node);
+		if (!sysfs_read_line(path, buf, sizeof(buf)))
+			break;
+		
+		n = MIN(parse_cpulist(buf, cpus_nodo, 1024), 1024);
+		for (j=0; j < n; j++)
+		for (i=0; i < count; i++)
+			if (topo->cpus[i].cpu == cpus_nodo[j])
+				topo->cpus[i].node = node;
+		
+		topo->node_count = node + 1;
+	}
+	
+	/*
+	 * Orden de cada procesador entre los hilos
+	 * de su mismo núcleo físico.
+	 */
+	for (i=0; i < count; i++) {
+		topo->cpus[i].smt = 0;
+		for (j=0; j < i; j++)
+			if (topo->cpus[j].package == topo->cpus[i].package && 
+					topo->cpus[j].core == topo->cpus[i].core)
+				topo->cpus[i].smt++;
+	}
+	
+	qsort(topo->cpus, count, sizeof(cpu_info_t), compare_cpus);
+	free(lista);
+	
+	return true;
+}
+
+void cpu_topology_free(cpu_topology_t *topo) {
+	free(topo->cpus);
+	topo->cpus      = NULL;
+	topo->cpu_count = 0;
+}
+
+void cpu_topology_place(const cpu_topology_t *topo, int count, int *place) {
+	int node, first, cpus_nodo, hilos_nodo, asignados = 0, acumulado = 0;
+	int i;
+	
+	/*
+	 * Los procesadores están ordenados por nodo. Cada
+	 * nodo recibe un bloque contiguo de hilos, en
+	 * proporción a su cantidad de procesadores.
+	 */
+	for (first=0; first < topo->cpu_count; first += cpus_nodo) {
+		node = topo->cpus[first].node;
+		for (cpus_nodo=0; first + cpus_nodo < topo->cpu_count && 
+				topo->cpus[first + cpus_nodo].node == node; cpus_nodo++)
+			;
+		
+		acumulado += cpus_nodo;
+		hilos_nodo = (int) ((long) count * acumulado / topo->cpu_count) - asignados;
+		
+		for (i=0; i < hilos_nodo; i++)
+			place[asignados + i] = first + i % cpus_nodo;
+		
+		asignados += hilos_nodo;
+	}
+}
+
+bool cpu_model_read(char *buf, int size) {
+	FILE *archivo = NULL;
+	char linea[256], *valor;
+	int len;
+	
+	snprintf(buf, size, "desconocido");
+	
+	if ((archivo = fopen(PROC_CPUINFO, "r")) == NULL)
+		return false;
+	
+	/*
+	 * Buscamos la primera línea "model name : ..."
+	 */
+	while (fgets(linea, sizeof(linea), archivo) != NULL) {
+		if (strncmp(linea, "model name", 10) != 0 || 
+				(valor = strchr(linea, ':')) == NULL)
+			continue;
+		
+		// Salteamos los espacios y el salto de línea final
+		for (valor++; *valor == ' ' || *valor == '\t'; valor++)
+			;
+		len = strlen(valor);
+		while (len > 0 && (valor[len - 1] == '\n' || valor[len - 1] == '\r'))
+			valor[--len] = '\0';
+		
+		snprintf(buf, size, "%s", valor);
+		fclose(archivo);
+		return true;
+	}
+	
+	fclose(archivo);
+	return false;
+}
+
+long huge_page_size(void) {
+	char buf[64];
+	long size = 0;
+	
+	if (sysfs_read_line(SYSFS_THP_PMD_SIZE, buf, sizeof(buf)))
+		size = atol(buf);
+	
+	return size > 0 ? size : DEFAULT_HUGE_PAGE_SIZE;
+}
+
+long hugetlb_page_size(void) {
+	FILE *archivo = NULL;
+	char linea[256];
+	long size = 0;
+	
+	if ((archivo = fopen(PROC_MEMINFO, "r")) == NULL)
+		return DEFAULT_HUGE_PAGE_SIZE;
+	
+	// Línea "Hugepagesize:    2048 kB"
+	while (fgets(linea, sizeof(linea), archivo) != NULL)
+		if (sscanf(linea, "Hugepagesize: %ld kB", &size) == 1)
+			break;
+	
+	fclose(archivo);
+	
+	return size > 0 ? size * 1024 : DEFAULT_HUGE_PAGE_SIZE;
+}
+
+bool thp_available(void) {
+	char buf[64];
+	
+	// El modo activo se indica entre corchetes
+	return sysfs_read_line(SYSFS_THP_ENABLED, buf, sizeof(buf)) && 
+			strstr(buf, "[never]") == NULL;
+}
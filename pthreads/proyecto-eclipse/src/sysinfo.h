@@ -0,0 +1,154 @@
+#ifndef SYSINFO_H_
+#define SYSINFO_H_
+
+#include "utils.h"
+
+/*
+ * Directorio de sysfs con la descripción
+ * de las cachés del procesador 0.
+ */
+#define SYSFS_CACHE_DIR "/sys/devices/system/cpu/cpu0/cache"
+
+/*
+ * Tamaños (en bytes) de los niveles de caché
+ * de datos. Un valor cero indica que el nivel
+ * no existe o no pudo determinarse.
+ */
+typedef struct {
+	long l1;
+	long l2;
+	long l3;
+} cache_info_t;
+
+/*
+ * Lee de sysfs los tamaños de las cachés de
+ * datos (o unificadas) de niveles 1, 2 y 3.
+ * Retorna false si no se pudo leer ningún nivel.
+ */
+bool cache_info_read(cache_info_t *info);
+
+/*
+ * Extensiones SIMD del procesador que pueden
+ * utilizarse (soportadas por el procesador y
+ * habilitadas por el sistema operativo).
+ */
+typedef struct {
+	bool avx2;
+	bool fma;
+	bool avx512f;
+	bool avx512bw;
+} cpu_features_t;
+
+/*
+ * Detecta las extensiones SIMD mediante la
+ * instrucción cpuid. En arquitecturas distintas
+ * de x86 todas quedan deshabilitadas.
+ */
+void cpu_features_read(cpu_features_t *features);
+
+/*
+ * Directorios de sysfs con la topología de
+ * procesadores y nodos NUMA.
+ */
+#define SYSFS_CPU_DIR  "/sys/devices/system/cpu"
+#define SYSFS_NODE_DIR "/sys/devices/system/node"
+
+/*
+ * Ubicación de un procesador lógico.
+ */
+typedef struct {
+	int cpu;		// Número de procesador lógico
+	int core;		// Núcleo físico (core_id)
+	int package;	// Socket (physical_package_id)
+	int node;		// Nodo NUMA
+	int smt;		// Orden entre los hilos del mismo núcleo
+} cpu_info_t;
+
+/*
+ * Topología de los procesadores en línea.
+ */
+typedef struct {
+	cpu_info_t *cpus;
+	int cpu_count;
+	int node_count;
+} cpu_topology_t;
+
+/*
+ * Lee de sysfs la topología de los procesadores
+ * en línea. Si no hay información de nodos NUMA,
+ * se asume un único nodo. Retorna false si no se
+ * pudo leer la lista de procesadores.
+ */
+bool cpu_topology_read(cpu_topology_t *topo);
+
+/*
+ * Libera la topología leída.
+ */
+void cpu_topology_free(cpu_topology_t *topo);
+
+/*
+ * Asigna un procesador a cada uno de "count" hilos.
+ * Los hilos se reparten en bloques contiguos entre
+ * los nodos NUMA, proporcionalmente a sus procesadores,
+ * y dentro de cada nodo se ocupan primero núcleos
+ * físicos distintos. En place[i] se guarda el índice
+ * (en topo->cpus) asignado al hilo i.
+ */
+void cpu_topology_place(const cpu_topology_t *topo, int count, int *place);
+
+/*
+ * Archivo con la descripción de los procesadores.
+ */
+#define PROC_CPUINFO "/proc/cpuinfo"
+
+/*
+ * Lee el nombre del modelo de procesador de
+ * PROC_CPUINFO. Retorna false (y "desconocido"
+ * en "buf") si no se encontró.
+ */
+bool cpu_model_read(char *buf, int size);
+
+/*
+ * Archivos de sysfs de las páginas grandes
+ * transparentes (THP), y tamaño de página grande
+ * asumido si no pueden leerse.
+ */
+#define SYSFS_THP_ENABLED  "/sys/kernel/mm/transparent_hugepage/enabled"
+#define SYSFS_THP_PMD_SIZE "/sys/kernel/mm/transparent_hugepage/hpage_pmd_size"
+#define DEFAULT_HUGE_PAGE_SIZE (2L * 1024 * 1024)
+
+/*
+ * Pseudo-archivo con el tamaño de página por
+ * defecto de hugetlbfs ("Hugepagesize").
+ */
+#define PROC_MEMINFO "/proc/meminfo"
+
+/*
+ * Tamaño (en bytes) de una página grande
+ * transparente.
+ */
+long huge_page_size(void);
+
+/*
+ * Tamaño (en bytes) de las páginas de hugetlbfs
+ * que se obtienen con MAP_HUGETLB (puede ser mayor
+ * que el de las transparentes, por ejemplo 1 GiB).
+ */
+long hugetlb_page_size(void);
+
+/*
+ * Retorna true si las páginas grandes transparentes
+ * pueden solicitarse con madvise() (modo "always"
+ * o "madvise").
+ */
+bool thp_available(void);
+
+/*
+ * Lee un archivo de sysfs (u otro pseudo-archivo)
+ * que contiene una única línea, y la almacena sin
+ * el salto de línea en "buf". Retorna false si el
+ * archivo no existe o no pudo leerse.
+ */
+bool sysfs_read_line(const char *path, char *buf, int size);
+
+#endif /*SYSINFO_H_*/
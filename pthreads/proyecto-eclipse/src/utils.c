@@ -9,6 +9,15 @@ void *xmalloc(size_t size) {
     return ptr;
 }
 
+void *xmalloc_aligned(size_t alignment, size_t size) {
+    void *ptr;
+    
+    if (posix_memalign(&ptr, alignment, size) != 0)
+        LOG(FATAL, "%s(): %s", __func__, "Memoria no disponible.");
+    
+    return ptr;
+}
+
 bool is_number(char *str) {
 	int i, len = strlen(str);
 	
@@ -32,21 +41,20 @@ bool es_cuadrado_perfecto(int numero) {
 	return false;
 }
 
-long long get_time_millis(void) {
-	long long segundos, milisegundos;
-	struct timeval tv;
+long long get_time_nanos(void) {
+	struct timespec ts;
 
-	if (gettimeofday(&tv, NULL) == -1)
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
 		LOG(FATAL, "%s(): %s", __func__, "Error al obtener el tiempo.");
 	
-	// Guardamos los tiempos en long long int
-	segundos     = tv.tv_sec;
-	milisegundos = tv.tv_usec;
+	return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
 
-	// Convertimos los tiempos en milisegundos
-	segundos     = segundos * 1000;
-	milisegundos = milisegundos / 1000;
+long long get_thread_cpu_nanos(void) {
+	struct timespec ts;
 
-	// Retornamos el resultado
-	return (segundos + milisegundos);
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == -1)
+		LOG(FATAL, "%s(): %s", __func__, "Error al obtener el tiempo del hilo.");
+	
+	return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
 }
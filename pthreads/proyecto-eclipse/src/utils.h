@@ -1,6 +1,14 @@
 #ifndef UTILS_H_
 #define UTILS_H_
 
+/*
+ * Extensiones de GNU (afinidad de hilos,
+ * CPU_SET, etc.).
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -15,6 +23,7 @@
 
 #include <math.h>
 #include <pthread.h>
+#include <sched.h>
 
 /*
  * Niveles de errores.
@@ -46,6 +55,14 @@ enum {INFO, WARN, FATAL};
  */
 void *xmalloc(size_t size);
 
+/*
+ * Asigna un bloque de memoria cuya dirección
+ * inicial es múltiplo de "alignment" (potencia
+ * de dos) y verifica los posibles fallos. El
+ * bloque se libera con free(3).
+ */
+void *xmalloc_aligned(size_t alignment, size_t size);
+
 /*
  * Verifica si una cadena dada está compuesta
  * únicamente por digitos decimales (0-9), 
@@ -75,11 +92,36 @@ bool es_cuadrado_perfecto(int numero);
 #define GET_MEM(type, blocks) (type *) xmalloc(blocks * sizeof(type))
 
 /*
- * Función que retorna el tiempo transcurrido
- * desde Epoch (ver time(2)).
- * La unidad de medida está en "milisegundos".
+ * Tamaño (en bytes) de una línea de caché.
+ */
+#define CACHE_LINE_SIZE 64
+
+/*
+ * Análogo a GET_MEM, pero el bloque queda
+ * alineado a una línea de caché.
  */
-long long get_time_millis(void);
+#define GET_MEM_ALIGNED(type, blocks) \
+	(type *) xmalloc_aligned(CACHE_LINE_SIZE, (blocks) * sizeof(type))
+
+/*
+ * Función que retorna el tiempo de un reloj
+ * monótono (ver clock_gettime(2)), que no se ve
+ * afectado por ajustes de la hora del sistema.
+ * La unidad de medida está en "nanosegundos".
+ */
+long long get_time_nanos(void);
+
+/*
+ * Función que retorna el tiempo de procesador
+ * consumido por el hilo que la invoca.
+ * La unidad de medida está en "nanosegundos".
+ */
+long long get_thread_cpu_nanos(void);
+
+/*
+ * Convierte nanosegundos a milisegundos.
+ */
+#define NANOS_TO_MILLIS(x) ((x) / 1e6)
 
 /* 
  * Tipo de dato para guardar
@@ -90,14 +132,31 @@ typedef struct {
 	long long end;
 } time_rec_t;
 
+/*
+ * Tiempos medidos por un hilo: instantes de
+ * comienzo y fin (reloj monótono) y tiempo de
+ * procesador consumido, en nanosegundos.
+ */
+typedef struct {
+	long long begin;
+	long long end;
+	long long cpu;
+} thread_time_t;
+
 /*
  * Macros para facilitar el control de
- * tiempo.
+ * tiempo (en nanosegundos).
  */
-#define TIME_BEGIN(x)  x.begin = get_time_millis()
-#define TIME_END(x)    x.end   = get_time_millis()
+#define TIME_BEGIN(x)  x.begin = get_time_nanos()
+#define TIME_END(x)    x.end   = get_time_nanos()
 #define TIME_DIFF(x)   (x.end - x.begin)
 
+/*
+ * Mínimo y máximo entre dos valores.
+ */
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
 /*
  * Conversión de un número a double. Normalmente
  * útil para realizar divisiones.